@@ -22,7 +22,7 @@ Please see the file LICENSE for full copyright and license details.
 --*/
 
 // This file uses the libsais library for linear time suffix array (SA)
-// and permuted longest common prefix array (PLCP) construction.
+// construction.
 //
 // See https://github.com/IlyaGrebnov/libsais for more information.
 //
@@ -39,15 +39,56 @@ Please see the file LICENSE for full copyright and license details.
 #include <string.h>
 #include <limits.h>
 
+#if defined(_WIN32)
+    #include <windows.h>
+
+    typedef HANDLE                                  ESA_MF_THREAD_HANDLE;
+    typedef CRITICAL_SECTION                        ESA_MF_MUTEX;
+    typedef CONDITION_VARIABLE                      ESA_MF_CONDITION;
+
+    #define esa_matchfinder_mutex_init(_m)          (InitializeCriticalSection(_m), 0)
+    #define esa_matchfinder_mutex_destroy(_m)       DeleteCriticalSection(_m)
+    #define esa_matchfinder_mutex_lock(_m)          EnterCriticalSection(_m)
+    #define esa_matchfinder_mutex_unlock(_m)        LeaveCriticalSection(_m)
+    #define esa_matchfinder_condition_init(_c)      (InitializeConditionVariable(_c), 0)
+    #define esa_matchfinder_condition_destroy(_c)   ((void)(_c))
+    #define esa_matchfinder_condition_wait(_c, _m)  SleepConditionVariableCS(_c, _m, INFINITE)
+    #define esa_matchfinder_condition_broadcast(_c) WakeAllConditionVariable(_c)
+#else
+    #include <pthread.h>
+
+    typedef pthread_t                               ESA_MF_THREAD_HANDLE;
+    typedef pthread_mutex_t                         ESA_MF_MUTEX;
+    typedef pthread_cond_t                          ESA_MF_CONDITION;
+
+    #define esa_matchfinder_mutex_init(_m)          pthread_mutex_init(_m, NULL)
+    #define esa_matchfinder_mutex_destroy(_m)       pthread_mutex_destroy(_m)
+    #define esa_matchfinder_mutex_lock(_m)          pthread_mutex_lock(_m)
+    #define esa_matchfinder_mutex_unlock(_m)        pthread_mutex_unlock(_m)
+    #define esa_matchfinder_condition_init(_c)      pthread_cond_init(_c, NULL)
+    #define esa_matchfinder_condition_destroy(_c)   pthread_cond_destroy(_c)
+    #define esa_matchfinder_condition_wait(_c, _m)  pthread_cond_wait(_c, _m)
+    #define esa_matchfinder_condition_broadcast(_c) pthread_cond_broadcast(_c)
+#endif
+
 #if defined(_OPENMP)
     #include <omp.h>
+#endif
 
-    #define ESA_MF_NUM_THREADS_MAX      (256)
-#else
-    #define ESA_MF_UNUSED(_x)           (void)(_x)
-    #define ESA_MF_NUM_THREADS_MAX      (1)
+#if !defined(_WIN32)
+    #include <unistd.h>
+    #include <sys/mman.h>
+
+    #if defined(MAP_ANONYMOUS)
+        #define ESA_MF_MAP_ANONYMOUS MAP_ANONYMOUS
+    #elif defined(MAP_ANON)
+        #define ESA_MF_MAP_ANONYMOUS MAP_ANON
+    #endif
 #endif
 
+#define ESA_MF_UNUSED(_x)               (void)(_x)
+#define ESA_MF_NUM_THREADS_MAX          (256)
+
 #define ESA_MF_TOTAL_BITS               (64)
 
 #define ESA_MF_LCP_BITS                 (ESA_MATCHFINDER_MATCH_BITS)
@@ -67,6 +108,37 @@ Please see the file LICENSE for full copyright and license details.
 
 #define ESA_MF_STORAGE_PADDING          (64)
 
+#define ESA_MF_HOT_INTERVALS_MAX_LCP    (2)
+#define ESA_MF_HOT_INTERVALS_SIZE       (8192)
+
+#define ESA_MF_DEFERRED_UPDATES_MAX     (1024)
+
+#define ESA_MF_CONVERT_GRAIN_SIZE       (131072)
+#define ESA_MF_CONVERT_CHUNK_SIZE       (1024)
+#define ESA_MF_BUILD_GRAIN_SIZE         (65536)
+#define ESA_MF_RESET_GRAIN_SIZE         (262144)
+#define ESA_MF_LPF_GRAIN_SIZE           (32768)
+#define ESA_MF_LPF_BINS_PER_THREAD      (4)
+#define ESA_MF_SORT_GRAIN_SIZE          (65536)
+
+#define ESA_MF_STREAM_THRESHOLD         (1 << 21)
+
+#define ESA_MF_SORT_BUCKETS             (257 * 257)
+#define ESA_MF_SORT_TINY_BLOCK_SIZE     (64)
+#define ESA_MF_SORT_INSERTION_THRESHOLD (16)
+
+#define ESA_MF_QUERY_LEVELS_MAX         (32)
+
+#define ESA_MF_DICTIONARY_BUCKETS       (256 * 257)
+
+#if LIBSAIS_VERSION_MAJOR != 2 || LIBSAIS_VERSION_MINOR != 7
+    #error "ESA_MF_LIBSAIS_* sizes mirror the allocations of libsais 2.7 (libsais_create_ctx_main, libsais_alloc_thread_state), update them for this libsais version."
+#endif
+
+#define ESA_MF_LIBSAIS_CTX_SIZE         (64 + 4096 + 8 * 256 * sizeof(int32_t))
+#define ESA_MF_LIBSAIS_THREAD_SIZE      (64 + 4 * 256 * sizeof(int32_t) + 24576 * 2 * sizeof(int32_t))
+#define ESA_MF_LIBSAIS_THREADS_OVERHEAD (3 * 4096)
+
 #if defined(__clang__)
     #pragma clang diagnostic push
     #pragma clang diagnostic ignored "-Wunreachable-code"
@@ -87,13 +159,46 @@ typedef struct ESA_MF_THREAD_STATE
 {
     ptrdiff_t               interval_tree_start;
     ptrdiff_t               interval_tree_end;
+    ptrdiff_t               hot_interval_tree_start;
+    ptrdiff_t               hot_interval_tree_end;
 } ESA_MF_THREAD_STATE;
 
+typedef struct ESA_MF_THREAD_POOL ESA_MF_THREAD_POOL;
+
+typedef struct ESA_MF_POOL_WORKER
+{
+    ESA_MF_THREAD_POOL *    pool;
+    int32_t                 index;
+} ESA_MF_POOL_WORKER;
+
+struct ESA_MF_THREAD_POOL
+{
+    esa_matchfinder_task    task;
+    void *                  task_context;
+    int32_t                 num_tasks;
+
+    uint64_t                generation;
+    int32_t                 pending;
+    int32_t                 terminate;
+    int32_t                 num_workers;
+
+    ESA_MF_MUTEX            mutex;
+    ESA_MF_CONDITION        work_condition;
+    ESA_MF_CONDITION        done_condition;
+
+    ESA_MF_POOL_WORKER      workers[ESA_MF_NUM_THREADS_MAX];
+    ESA_MF_THREAD_HANDLE    handles[ESA_MF_NUM_THREADS_MAX];
+};
+
 typedef struct ESA_MF_CONTEXT
 {
     uint64_t                prefetch[4][8];
     uint64_t                position;
 
+    uint64_t                deferred_count;
+    uint64_t                deferred_lcp;
+    uint64_t                deferred_updates[ESA_MF_DEFERRED_UPDATES_MAX];
+
     uint64_t *              sa_parent_link;
     uint32_t *              plcp_leaf_link;
     uint64_t                min_match_length_minus_1;
@@ -101,15 +206,74 @@ typedef struct ESA_MF_CONTEXT
     int32_t *               esa_storage;
     void *                  libsais_ctx;
 
+    esa_matchfinder_parallel_for parallel_for;
+    void *                  parallel_for_context;
+    ESA_MF_THREAD_POOL *    thread_pool;
+
+    const uint8_t *         block;
+    const void *            dictionary;
+    uint8_t *               delta_block;
+    uint64_t *              cursor_parent_link;
+
+    uint32_t *              query_intervals;
+    uint32_t *              query_ranks;
+    uint64_t *              query_bitmap;
+    void *                  query_storage;
+    int64_t                 query_words;
+    int64_t                 query_levels;
+    uint64_t                query_zeros[ESA_MF_QUERY_LEVELS_MAX];
+
     int32_t                 block_size;
     int32_t                 max_block_size;
+    int32_t                 hot_intervals_size;
+    int32_t                 fixed_layout;
     int32_t                 min_match_length;
     int32_t                 max_match_length;
     int32_t                 num_threads;
+    int32_t                 parse_num_threads;
+    int32_t                 sort_mode;
+    int32_t                 isa;
 
     ESA_MF_THREAD_STATE     threads[ESA_MF_NUM_THREADS_MAX];
 } ESA_MF_CONTEXT;
 
+typedef struct ESA_MF_DICTIONARY
+{
+    ESA_MF_CONTEXT *        matchfinder_ctx;
+
+    uint8_t *               text;
+    uint32_t *              SA;
+    uint32_t *              buckets;
+
+    int32_t                 size;
+} ESA_MF_DICTIONARY;
+
+typedef struct ESA_MF_PIPELINE
+{
+    void *                  matchfinders[2];
+
+    const uint8_t *         block;
+    int32_t                 block_size;
+    int32_t                 block_result;
+
+    int32_t                 current;
+    int32_t                 pending;
+    int32_t                 completed;
+    int32_t                 terminate;
+
+    ESA_MF_MUTEX            mutex;
+    ESA_MF_CONDITION        condition;
+    ESA_MF_THREAD_HANDLE    thread;
+} ESA_MF_PIPELINE;
+
+typedef struct ESA_MF_CURSOR
+{
+    uint64_t                position;
+
+    const ESA_MF_CONTEXT *  matchfinder_ctx;
+    uint32_t *              offsets;
+} ESA_MF_CURSOR;
+
 #if defined(__GNUC__) || defined(__clang__)
     #define ESA_MF_RESTRICT __restrict__
 #elif defined(_MSC_VER) || defined(__INTEL_COMPILER)
@@ -145,6 +309,24 @@ typedef struct ESA_MF_CONTEXT
     #error Your compiler, configuration or platform is not supported.
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+    #define esa_matchfinder_popcount64(x) ((uint64_t)__builtin_popcountll(x))
+#else
+    static uint64_t esa_matchfinder_popcount64(uint64_t x)
+    {
+        x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+        x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+        x = (x + (x >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+        return (x * UINT64_C(0x0101010101010101)) >> 56;
+    }
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define esa_matchfinder_ctz64(x) ((uint64_t)__builtin_ctzll(x))
+#else
+    #define esa_matchfinder_ctz64(x) esa_matchfinder_popcount64(((x) & (0 - (x))) - 1)
+#endif
+
 #if !defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
     #if defined(_LITTLE_ENDIAN) \
             || (defined(BYTE_ORDER) && defined(LITTLE_ENDIAN) && BYTE_ORDER == LITTLE_ENDIAN) \
@@ -165,6 +347,31 @@ typedef struct ESA_MF_CONTEXT
     #endif
 #endif
 
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ESA_MF_HAS_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)) && defined(__LITTLE_ENDIAN__)
+    #include <arm_neon.h>
+    #define ESA_MF_HAS_NEON
+#endif
+
+#if defined(ESA_MF_HAS_SSE2) && (defined(__x86_64__) || defined(_M_AMD64) || defined(_M_X64))
+    #if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5))
+        #include <immintrin.h>
+        #define ESA_MF_HAS_AVX2
+        #define ESA_MF_HAS_AVX512
+        #define ESA_MF_TARGET_AVX2      __attribute__((target("avx2")))
+        #define ESA_MF_TARGET_AVX512    __attribute__((target("avx512f")))
+    #elif defined(_MSC_VER) && (_MSC_VER >= 1910)
+        #include <immintrin.h>
+        #include <intrin.h>
+        #define ESA_MF_HAS_AVX2
+        #define ESA_MF_HAS_AVX512
+        #define ESA_MF_TARGET_AVX2
+        #define ESA_MF_TARGET_AVX512
+    #endif
+#endif
+
 static void * esa_matchfinder_align_up(const void * address, size_t alignment)
 {
     return (void *)((((ptrdiff_t)address) + ((ptrdiff_t)alignment) - 1) & (-((ptrdiff_t)alignment)));
@@ -194,623 +401,2501 @@ static void esa_matchfinder_free_aligned(void * aligned_address)
 
 static void esa_matchfinder_set_position(ESA_MF_CONTEXT * matchfinder_ctx, uint64_t position)
 {
-    matchfinder_ctx->position = position;
+    matchfinder_ctx->position       = position;
+    matchfinder_ctx->deferred_count = 0;
+    matchfinder_ctx->deferred_lcp   = 0;
     memset(matchfinder_ctx->prefetch, 0, sizeof(matchfinder_ctx->prefetch));
 }
 
-static ESA_MF_CONTEXT * esa_matchfinder_alloc_ctx(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads)
+static void esa_matchfinder_pool_worker(ESA_MF_POOL_WORKER * worker)
 {
-    num_threads                             = num_threads < ESA_MF_NUM_THREADS_MAX ? num_threads : ESA_MF_NUM_THREADS_MAX;
-    max_block_size                          = (max_block_size + ESA_MF_STORAGE_PADDING - 1) & (-ESA_MF_STORAGE_PADDING);
-
-    ESA_MF_CONTEXT *    matchfinder_ctx     = (ESA_MF_CONTEXT *)esa_matchfinder_alloc_aligned(sizeof(ESA_MF_CONTEXT), ESA_MF_STORAGE_PADDING);
-    int32_t *           esa_storage         = (int32_t *)esa_matchfinder_alloc_aligned((2 * ESA_MF_STORAGE_PADDING + 3 * (size_t)max_block_size) * sizeof(int32_t), ESA_MF_STORAGE_PADDING);
+    ESA_MF_THREAD_POOL *    pool        = worker->pool;
+    uint64_t                generation  = 0;
 
-#if defined(_OPENMP)
-    void *              libsais_ctx         = libsais_create_ctx_omp(num_threads);
-#else
-    void *              libsais_ctx         = libsais_create_ctx();
-#endif
+    esa_matchfinder_mutex_lock(&pool->mutex);
 
-    if (matchfinder_ctx != NULL && esa_storage != NULL && libsais_ctx != NULL)
+    for (;;)
     {
-        matchfinder_ctx->esa_storage                = esa_storage;
-        matchfinder_ctx->libsais_ctx                = libsais_ctx;
-
-        matchfinder_ctx->block_size                 = -1;
-        matchfinder_ctx->max_block_size             = max_block_size;
-        matchfinder_ctx->min_match_length           = min_match_length;
-        matchfinder_ctx->max_match_length           = max_match_length;
-        matchfinder_ctx->num_threads                = num_threads;
-
-        matchfinder_ctx->sa_parent_link             = (uint64_t *)(void *)(matchfinder_ctx->esa_storage + ESA_MF_STORAGE_PADDING) + 0 * matchfinder_ctx->max_block_size;
-        matchfinder_ctx->plcp_leaf_link             = (uint32_t *)(void *)(matchfinder_ctx->esa_storage + ESA_MF_STORAGE_PADDING) + 2 * matchfinder_ctx->max_block_size;
-        matchfinder_ctx->min_match_length_minus_1   = (uint64_t)matchfinder_ctx->min_match_length - 1;
+        while (!pool->terminate && pool->generation == generation)
+        {
+            esa_matchfinder_condition_wait(&pool->work_condition, &pool->mutex);
+        }
 
-        esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)-1);
+        if (pool->terminate)
+        {
+            break;
+        }
 
-        return matchfinder_ctx;
-    }
+        generation = pool->generation;
 
-    libsais_free_ctx(libsais_ctx);
+        if (worker->index < pool->num_tasks)
+        {
+            esa_matchfinder_task    task            = pool->task;
+            void *                  task_context    = pool->task_context;
+            int32_t                 num_tasks       = pool->num_tasks;
 
-    esa_matchfinder_free_aligned(esa_storage);
-    esa_matchfinder_free_aligned(matchfinder_ctx);
+            esa_matchfinder_mutex_unlock(&pool->mutex);
 
-    return NULL;
-}
+            task(task_context, worker->index, num_tasks);
 
-static void esa_matchfinder_free_ctx(ESA_MF_CONTEXT * matchfinder_ctx)
-{
-    if (matchfinder_ctx != NULL)
-    {
-        libsais_free_ctx(matchfinder_ctx->libsais_ctx);
+            esa_matchfinder_mutex_lock(&pool->mutex);
 
-        esa_matchfinder_free_aligned(matchfinder_ctx->esa_storage);
-        esa_matchfinder_free_aligned(matchfinder_ctx);
+            if (--pool->pending == 0)
+            {
+                esa_matchfinder_condition_broadcast(&pool->done_condition);
+            }
+        }
     }
+
+    esa_matchfinder_mutex_unlock(&pool->mutex);
 }
 
-static void esa_matchfinder_convert_right_to_left_32u_to_64u(uint32_t * S, uint64_t * D, ptrdiff_t omp_block_start, ptrdiff_t omp_block_size)
+#if defined(_WIN32)
+
+static DWORD WINAPI esa_matchfinder_pool_thread(LPVOID worker)
 {
-    ptrdiff_t i, j; for (i = omp_block_start + omp_block_size - 1, j = omp_block_start; i >= j; i -= 1) { D[i] = (uint64_t)S[i]; }
+    esa_matchfinder_pool_worker((ESA_MF_POOL_WORKER *)worker); return 0;
 }
 
-static void esa_matchfinder_convert_left_to_right_32u_to_64u(uint32_t * ESA_MF_RESTRICT S, uint64_t * ESA_MF_RESTRICT D, ptrdiff_t omp_block_start, ptrdiff_t omp_block_size)
+#else
+
+static void * esa_matchfinder_pool_thread(void * worker)
 {
-    ptrdiff_t i, j; for (i = omp_block_start, j = omp_block_start + omp_block_size; i < j; i += 1) { D[i] = (uint64_t)S[i]; }
+    esa_matchfinder_pool_worker((ESA_MF_POOL_WORKER *)worker); return NULL;
 }
 
-static void esa_matchfinder_convert_inplace_32u_to_64u_omp(uint32_t * S, uint64_t * D, ptrdiff_t n, ptrdiff_t num_threads)
+#endif
+
+static void esa_matchfinder_destroy_thread_pool(ESA_MF_THREAD_POOL * pool)
 {
-    while (n >= 65536)
+    if (pool != NULL)
     {
-        ptrdiff_t block_size = n >> 1; n -= block_size;
+        esa_matchfinder_mutex_lock(&pool->mutex);
+        pool->terminate = 1;
+        esa_matchfinder_condition_broadcast(&pool->work_condition);
+        esa_matchfinder_mutex_unlock(&pool->mutex);
 
-#if defined(_OPENMP)
-        #pragma omp parallel num_threads(num_threads) if(num_threads > 1)
-#endif
+        for (int32_t index = 1; index <= pool->num_workers; index += 1)
         {
-#if defined(_OPENMP)
-            ptrdiff_t omp_thread_num      = omp_get_thread_num();
-            ptrdiff_t omp_num_threads     = omp_get_num_threads();
+#if defined(_WIN32)
+            WaitForSingleObject(pool->handles[index], INFINITE);
+            CloseHandle(pool->handles[index]);
 #else
-            ESA_MF_UNUSED(num_threads);
-
-            ptrdiff_t omp_thread_num      = 0;
-            ptrdiff_t omp_num_threads     = 1;
+            pthread_join(pool->handles[index], NULL);
 #endif
-            ptrdiff_t omp_block_stride    = (block_size / omp_num_threads) & (-16);
-            ptrdiff_t omp_block_start     = omp_thread_num * omp_block_stride;
-            ptrdiff_t omp_block_size      = omp_thread_num < omp_num_threads - 1 ? omp_block_stride : block_size - omp_block_start;
-
-            esa_matchfinder_convert_left_to_right_32u_to_64u(S, D, n + omp_block_start, omp_block_size);
         }
-    }
 
-    esa_matchfinder_convert_right_to_left_32u_to_64u(S, D, 0, n);
-}
+        esa_matchfinder_condition_destroy(&pool->done_condition);
+        esa_matchfinder_condition_destroy(&pool->work_condition);
+        esa_matchfinder_mutex_destroy(&pool->mutex);
 
-static void esa_matchfinder_reset_interval_tree(uint64_t * ESA_MF_RESTRICT sa_parent_link, ptrdiff_t omp_block_start, ptrdiff_t omp_block_size)
-{
-    ptrdiff_t i, j; for (i = omp_block_start, j = omp_block_start + omp_block_size; i < j; i += 1) { sa_parent_link[i] &= (~ESA_MF_OFFSET_MASK); }
+        esa_matchfinder_free_aligned(pool);
+    }
 }
 
-static void esa_matchfinder_reset_interval_tree_omp(uint64_t * ESA_MF_RESTRICT sa_parent_link, ptrdiff_t n, ptrdiff_t num_threads)
+static ESA_MF_THREAD_POOL * esa_matchfinder_create_thread_pool(int32_t num_threads)
 {
-#if defined(_OPENMP)
-    #pragma omp parallel num_threads(num_threads) if(num_threads > 1 && n >= 65536)
-#endif
-    {
-#if defined(_OPENMP)
-        ptrdiff_t omp_thread_num      = omp_get_thread_num();
-        ptrdiff_t omp_num_threads     = omp_get_num_threads();
-#else
-        ESA_MF_UNUSED(num_threads);
-
-        ptrdiff_t omp_thread_num      = 0;
-        ptrdiff_t omp_num_threads     = 1;
-#endif
-        ptrdiff_t omp_block_stride    = (n / omp_num_threads) & (-16);
-        ptrdiff_t omp_block_start     = omp_thread_num * omp_block_stride;
-        ptrdiff_t omp_block_size      = omp_thread_num < omp_num_threads - 1 ? omp_block_stride : n - omp_block_start;
+    ESA_MF_THREAD_POOL * pool = (ESA_MF_THREAD_POOL *)esa_matchfinder_alloc_aligned(sizeof(ESA_MF_THREAD_POOL), ESA_MF_STORAGE_PADDING);
 
-        esa_matchfinder_reset_interval_tree(sa_parent_link, omp_block_start, omp_block_size);
+    if (pool == NULL)
+    {
+        return NULL;
     }
-}
 
-static void esa_matchfinder_fast_forward
-(
-    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
-    uint32_t * ESA_MF_RESTRICT  plcp_leaf_link,
-    uint64_t                    target_position
-)
-{
-    const uint64_t  prefetch_distance   = 32;
-    uint64_t        position            = target_position - 1;
+    memset(pool, 0, sizeof(ESA_MF_THREAD_POOL));
 
-    for (; position >= prefetch_distance; position -= 1)
+    if (esa_matchfinder_mutex_init(&pool->mutex) == 0)
     {
-        esa_matchfinder_prefetchr(&plcp_leaf_link[position - 2 * prefetch_distance]);
-        esa_matchfinder_prefetchw(&sa_parent_link[plcp_leaf_link[position - prefetch_distance]]);
+        if (esa_matchfinder_condition_init(&pool->work_condition) == 0)
+        {
+            if (esa_matchfinder_condition_init(&pool->done_condition) == 0)
+            {
+                for (int32_t index = 1; index < num_threads; index += 1)
+                {
+                    pool->workers[index].pool   = pool;
+                    pool->workers[index].index  = index;
 
-        const uint64_t offset           = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-        uint64_t reference              = plcp_leaf_link[position];
-        uint64_t interval               = sa_parent_link[reference];
+#if defined(_WIN32)
+                    pool->handles[index] = CreateThread(NULL, 0, esa_matchfinder_pool_thread, &pool->workers[index], 0, NULL);
+                    if (pool->handles[index] == NULL) { break; }
+#else
+                    if (pthread_create(&pool->handles[index], NULL, esa_matchfinder_pool_thread, &pool->workers[index]) != 0) { break; }
+#endif
 
-        while ((interval & ESA_MF_OFFSET_MASK) == 0)
-        {
-            sa_parent_link[reference]   = interval + offset;
-            reference                   = (uint32_t)interval;
-            interval                    = sa_parent_link[reference];
-        }
-    }
+                    pool->num_workers = index;
+                }
 
-    for (; position > 0; position -= 1)
-    {
-        const uint64_t offset           = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-        uint64_t reference              = plcp_leaf_link[position];
-        uint64_t interval               = sa_parent_link[reference];
+                return pool;
+            }
 
-        while ((interval & ESA_MF_OFFSET_MASK) == 0)
-        {
-            sa_parent_link[reference]   = interval + offset;
-            reference                   = (uint32_t)interval;
-            interval                    = sa_parent_link[reference];
+            esa_matchfinder_condition_destroy(&pool->work_condition);
         }
+
+        esa_matchfinder_mutex_destroy(&pool->mutex);
     }
-}
 
-static ptrdiff_t esa_matchfinder_build_interval_tree
-(
-    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
-    uint32_t * ESA_MF_RESTRICT  plcp_leaf_link,
-    uint64_t                    min_match_length,
-    uint64_t                    max_match_length,
-    ptrdiff_t                   omp_block_start,
-    ptrdiff_t                   omp_block_size
-)
-{
-    uint64_t intervals[2 * ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+    esa_matchfinder_free_aligned(pool);
 
-    const ptrdiff_t             prefetch_distance       = 32;
-    uint64_t * ESA_MF_RESTRICT  stack                   = intervals;
-    uint64_t                    top_interval            = stack[0] = 0;
-    uint64_t                    next_interval_index     = (uint64_t)(omp_block_start + omp_block_size - 1);
+    return NULL;
+}
 
-    min_match_length -= 1;
-    max_match_length -= min_match_length;
+static void esa_matchfinder_default_parallel_for(void * context, int32_t num_tasks, esa_matchfinder_task task, void * task_context)
+{
+    ESA_MF_THREAD_POOL *    pool        = (ESA_MF_THREAD_POOL *)context;
+    int32_t                 num_pooled  = num_tasks - 1 < pool->num_workers ? num_tasks - 1 : pool->num_workers;
 
-    for (ptrdiff_t i = omp_block_start + omp_block_size - 1; i >= omp_block_start; i -= 1)
+    if (num_pooled > 0)
     {
-        esa_matchfinder_prefetchr(&sa_parent_link[i - 2 * prefetch_distance]);
-
-        esa_matchfinder_prefetchw(&plcp_leaf_link[sa_parent_link[i - prefetch_distance]]);
-        esa_matchfinder_prefetchw(&sa_parent_link[next_interval_index - prefetch_distance]);
+        esa_matchfinder_mutex_lock(&pool->mutex);
 
-        uint64_t next_pos                   =  sa_parent_link[i];
-        uint64_t next_lcp                   =  (uint64_t)plcp_leaf_link[next_pos] - min_match_length;
+        pool->task          = task;
+        pool->task_context  = task_context;
+        pool->num_tasks     = num_pooled + 1;
+        pool->pending       = num_pooled;
+        pool->generation   += 1;
 
-        if ((int64_t)next_lcp < 0)          {  next_lcp = 0; }
-        if (next_lcp > max_match_length)    {  next_lcp = max_match_length; }
+        esa_matchfinder_condition_broadcast(&pool->work_condition);
+        esa_matchfinder_mutex_unlock(&pool->mutex);
+    }
 
-        uint64_t next_interval              =  (next_lcp << ESA_MF_LCP_SHIFT) + next_interval_index;
-        uint64_t top_interval_lcp           =  top_interval >> ESA_MF_LCP_SHIFT;
+    task(task_context, 0, num_tasks);
 
-        stack[1]                            =  next_interval;
-        top_interval                        =  next_lcp > top_interval_lcp ? next_interval : top_interval;
-        next_interval_index                 -= next_lcp > top_interval_lcp;
-        stack                               += next_lcp > top_interval_lcp;
+    for (int32_t index = num_pooled + 1; index < num_tasks; index += 1)
+    {
+        task(task_context, index, num_tasks);
+    }
 
-        plcp_leaf_link[next_pos]            =  (uint32_t)top_interval;
+    if (num_pooled > 0)
+    {
+        esa_matchfinder_mutex_lock(&pool->mutex);
 
-        while (next_lcp < top_interval_lcp)
+        while (pool->pending > 0)
         {
-            uint64_t closed_interval        =  top_interval;
-            
-            stack                           =  stack - 1;
-            top_interval                    =  stack[0];
-            top_interval_lcp                =  top_interval >> ESA_MF_LCP_SHIFT;
-
-            stack[1]                        =  next_interval;
-            top_interval                    =  next_lcp > top_interval_lcp ? next_interval : top_interval;
-            next_interval_index             -= next_lcp > top_interval_lcp;
-            stack                           += next_lcp > top_interval_lcp;
-            
-            sa_parent_link[(uint32_t)closed_interval] = (uint32_t)top_interval + (closed_interval & ESA_MF_LCP_MASK);
+            esa_matchfinder_condition_wait(&pool->done_condition, &pool->mutex);
         }
+
+        esa_matchfinder_mutex_unlock(&pool->mutex);
     }
+}
+
+static int32_t esa_matchfinder_default_num_threads(void)
+{
+#if defined(_OPENMP)
+    return omp_get_max_threads();
+#elif defined(_WIN32)
+    SYSTEM_INFO system_info; GetSystemInfo(&system_info); return (int32_t)system_info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN); return num_threads > 0 ? (int32_t)num_threads : 1;
+#else
+    return 1;
+#endif
+}
 
-    return (ptrdiff_t)(next_interval_index + 1);
+static ptrdiff_t esa_matchfinder_num_tasks(ptrdiff_t num_threads, ptrdiff_t n, ptrdiff_t grain_size)
+{
+    ptrdiff_t num_tasks = n / grain_size;
+    return num_tasks > 1 ? (num_tasks < num_threads ? num_tasks : num_threads) : 1;
 }
 
+static void esa_matchfinder_run_tasks(const ESA_MF_CONTEXT * matchfinder_ctx, ptrdiff_t num_tasks, esa_matchfinder_task task, void * task_context)
+{
+    if (num_tasks > 1 && matchfinder_ctx->parallel_for != NULL)
+    {
+        matchfinder_ctx->parallel_for(matchfinder_ctx->parallel_for_context, (int32_t)num_tasks, task, task_context);
+        return;
+    }
+
 #if defined(_OPENMP)
+    #pragma omp parallel for schedule(static, 1) num_threads(num_tasks) if(num_tasks > 1)
+#endif
+    for (ptrdiff_t index = 0; index < num_tasks; index += 1)
+    {
+        task(task_context, (int32_t)index, (int32_t)num_tasks);
+    }
+}
 
-static ptrdiff_t esa_matchfinder_find_breakpoint
-(
-    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
-    uint32_t * ESA_MF_RESTRICT  plcp_leaf_link,
-    uint32_t                    min_match_length,
-    ptrdiff_t                   omp_block_start,
-    ptrdiff_t                   omp_block_size
-)
+static int32_t esa_matchfinder_detect_isa(void)
 {
-    const ptrdiff_t prefetch_distance = 32;
+#if defined(ESA_MF_HAS_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+    int registers[4]; __cpuid(registers, 0);
 
-    for (ptrdiff_t i = omp_block_start + omp_block_size - 1; i >= omp_block_start; i -= 1)
+    if (registers[0] >= 7)
     {
-        esa_matchfinder_prefetchr(&sa_parent_link[i - 2 * prefetch_distance]);
-        esa_matchfinder_prefetchr(&plcp_leaf_link[sa_parent_link[i - prefetch_distance]]);
+        __cpuid(registers, 1);
 
-        if (plcp_leaf_link[sa_parent_link[i]] < min_match_length)
+        if ((registers[2] & (1 << 27)) != 0 && (registers[2] & (1 << 28)) != 0)
         {
-            return i;
+            uint64_t xcr0 = (uint64_t)_xgetbv(0); __cpuidex(registers, 7, 0);
+
+            if ((registers[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6) { return ESA_MATCHFINDER_ISA_AVX512; }
+            if ((registers[1] & (1 <<  5)) != 0 && (xcr0 & 0x06) == 0x06) { return ESA_MATCHFINDER_ISA_AVX2; }
         }
     }
 
-    return -1;
+    return ESA_MATCHFINDER_ISA_SSE2;
+#elif defined(ESA_MF_HAS_AVX2)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))  { return ESA_MATCHFINDER_ISA_AVX512; }
+    if (__builtin_cpu_supports("avx2"))     { return ESA_MATCHFINDER_ISA_AVX2; }
+
+    return ESA_MATCHFINDER_ISA_SSE2;
+#elif defined(ESA_MF_HAS_SSE2)
+    return ESA_MATCHFINDER_ISA_SSE2;
+#elif defined(ESA_MF_HAS_NEON)
+    return ESA_MATCHFINDER_ISA_NEON;
+#else
+    return ESA_MATCHFINDER_ISA_GENERIC;
+#endif
 }
 
+static size_t esa_matchfinder_page_size(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO system_info; GetSystemInfo(&system_info); return (size_t)system_info.dwPageSize;
+#elif defined(_SC_PAGESIZE)
+    long page_size = sysconf(_SC_PAGESIZE); return page_size > 0 ? (size_t)page_size : 4096;
+#else
+    return 4096;
 #endif
+}
 
-static void esa_matchfinder_build_interval_tree_omp
-(
-    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
-    uint32_t * ESA_MF_RESTRICT  plcp_leaf_link,
-    uint64_t                    min_match_length,
-    uint64_t                    max_match_length,
-    ptrdiff_t                   n,
-    ptrdiff_t                   num_threads,
-    ESA_MF_THREAD_STATE *       threads
-)
+static void * esa_matchfinder_alloc_pages(size_t size)
 {
-#if defined(_OPENMP)
-    ptrdiff_t breakpoints[ESA_MF_NUM_THREADS_MAX];
-
-    for (ptrdiff_t thread = 0; thread < num_threads; thread += 1)
-    {
-        threads[thread].interval_tree_start = 0;
-        threads[thread].interval_tree_end   = 0;
-    }
-
-    #pragma omp parallel num_threads(num_threads) if(num_threads > 1 && n >= 65536)
-#endif
-    {
-#if defined(_OPENMP)
-        ptrdiff_t omp_thread_num      = omp_get_thread_num();
-        ptrdiff_t omp_num_threads     = omp_get_num_threads();
+#if defined(_WIN32)
+    return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(ESA_MF_MAP_ANONYMOUS)
+    void * address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | ESA_MF_MAP_ANONYMOUS, -1, 0);
+    return address != MAP_FAILED ? address : NULL;
 #else
-        ESA_MF_UNUSED(num_threads);
-
-        ptrdiff_t omp_thread_num      = 0;
-        ptrdiff_t omp_num_threads     = 1;
+    return esa_matchfinder_alloc_aligned(size, ESA_MF_STORAGE_PADDING);
 #endif
-        ptrdiff_t omp_block_stride    = (n / omp_num_threads) & (-16);
-        ptrdiff_t omp_block_start     = omp_thread_num * omp_block_stride;
-        ptrdiff_t omp_block_size      = omp_thread_num < omp_num_threads - 1 ? omp_block_stride : n - omp_block_start;
-        ptrdiff_t omp_block_end       = omp_block_start + omp_block_size;
-
-        if (omp_num_threads == 1)
-        {
-            threads[omp_thread_num].interval_tree_end   = omp_block_end;
-            threads[omp_thread_num].interval_tree_start = esa_matchfinder_build_interval_tree(
-                sa_parent_link,
-                plcp_leaf_link,
-                min_match_length,
-                max_match_length,
-                omp_block_start,
-                omp_block_end - omp_block_start);
-        }
-#if defined(_OPENMP)
-        else
-        {
-            {
-                breakpoints[omp_thread_num] = omp_thread_num < omp_num_threads - 1
-                    ? esa_matchfinder_find_breakpoint(sa_parent_link, plcp_leaf_link, (uint32_t)min_match_length, omp_block_start, omp_block_end - omp_block_start)
-                    : n;
-            }
-
-            #pragma omp barrier
+}
 
-            {
-                if (breakpoints[omp_thread_num] != -1)
-                {
-                    omp_block_end       = breakpoints[omp_thread_num];
-                    omp_block_start     = 0;
-
-                    for (ptrdiff_t thread = omp_thread_num - 1; thread >= 0; thread -= 1)
-                    { 
-                        if (breakpoints[thread] != -1) { omp_block_start = breakpoints[thread]; break; }
-                    }
-
-                    if (omp_block_start < omp_block_end)
-                    {
-                        threads[omp_thread_num].interval_tree_end   = omp_block_end;
-                        threads[omp_thread_num].interval_tree_start = esa_matchfinder_build_interval_tree(
-                            sa_parent_link,
-                            plcp_leaf_link,
-                            min_match_length,
-                            max_match_length,
-                            omp_block_start,
-                            omp_block_end - omp_block_start);
-                    }
-                }
-            }
-        }
+static void esa_matchfinder_free_pages(void * address, size_t size)
+{
+    if (address != NULL)
+    {
+#if defined(_WIN32)
+        VirtualFree(address, 0, MEM_RELEASE); ESA_MF_UNUSED(size);
+#elif defined(ESA_MF_MAP_ANONYMOUS)
+        munmap(address, size);
+#else
+        esa_matchfinder_free_aligned(address); ESA_MF_UNUSED(size);
 #endif
     }
+}
 
+static void esa_matchfinder_trim_pages(void * address, size_t size, size_t new_size)
+{
+    size_t      page_size   = esa_matchfinder_page_size();
+    uint8_t *   begin       = (uint8_t *)esa_matchfinder_align_up((uint8_t *)address + new_size, page_size);
+    uint8_t *   end         = (uint8_t *)esa_matchfinder_align_up((uint8_t *)address + size, page_size);
+
+    if (begin < end)
     {
-        sa_parent_link[0] = ESA_MF_OFFSET_MASK;
+#if defined(_WIN32)
+        VirtualFree(begin, (size_t)(end - begin), MEM_DECOMMIT);
+#elif defined(ESA_MF_MAP_ANONYMOUS)
+        munmap(begin, (size_t)(end - begin));
+#endif
     }
 }
 
-void * esa_matchfinder_create(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length)
+static void esa_matchfinder_release_pages(void * address, size_t size)
 {
-    if ((max_block_size     < 0) ||
-        (max_block_size     > ESA_MATCHFINDER_MAX_BLOCK_SIZE) ||
-        (min_match_length   < ESA_MATCHFINDER_MIN_MATCH_LENGTH) ||
-        (max_match_length   > (int32_t)ESA_MF_LCP_MAX + min_match_length - 1) ||
-        (max_match_length   < min_match_length))
+    size_t      page_size   = esa_matchfinder_page_size();
+    uint8_t *   begin       = (uint8_t *)esa_matchfinder_align_up(address, page_size);
+    uint8_t *   end         = (uint8_t *)(void *)(((uintptr_t)address + size) & (~(uintptr_t)(page_size - 1)));
+
+    if (begin < end)
     {
-        return NULL;
+#if defined(_WIN32)
+        VirtualAlloc(begin, (size_t)(end - begin), MEM_RESET, PAGE_READWRITE);
+#elif defined(ESA_MF_MAP_ANONYMOUS) && defined(MADV_DONTNEED)
+        madvise(begin, (size_t)(end - begin), MADV_DONTNEED);
+#endif
     }
+}
 
-    return (void *)esa_matchfinder_alloc_ctx(max_block_size, min_match_length, max_match_length, 1);
+static int32_t esa_matchfinder_hot_intervals_size(int32_t max_block_size)
+{
+    int32_t hot_intervals_size = max_block_size < ESA_MF_HOT_INTERVALS_SIZE ? max_block_size : ESA_MF_HOT_INTERVALS_SIZE;
+    return hot_intervals_size > ESA_MF_STORAGE_PADDING ? hot_intervals_size : ESA_MF_STORAGE_PADDING;
 }
 
-#if defined(_OPENMP)
+static size_t esa_matchfinder_storage_size(int32_t max_block_size)
+{
+    return (2 * ESA_MF_STORAGE_PADDING + 3 * (size_t)max_block_size + 2 * (size_t)esa_matchfinder_hot_intervals_size(max_block_size)) * sizeof(int32_t);
+}
 
-void * esa_matchfinder_create_omp(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads)
+static void esa_matchfinder_set_block_layout(ESA_MF_CONTEXT * matchfinder_ctx, int32_t block_size)
 {
-    if ((max_block_size     < 0) ||
-        (max_block_size     > ESA_MATCHFINDER_MAX_BLOCK_SIZE) ||
-        (min_match_length   < ESA_MATCHFINDER_MIN_MATCH_LENGTH) ||
-        (max_match_length   > (int32_t)ESA_MF_LCP_MAX + min_match_length - 1) ||
-        (max_match_length   < min_match_length) ||
-        (num_threads        < 0))
-    {
-        return NULL;
-    }
+    matchfinder_ctx->hot_intervals_size         = esa_matchfinder_hot_intervals_size((block_size + ESA_MF_STORAGE_PADDING - 1) & (-ESA_MF_STORAGE_PADDING));
 
-    num_threads = num_threads > 0 ? num_threads : omp_get_max_threads();
-    return (void *)esa_matchfinder_alloc_ctx(max_block_size, min_match_length, max_match_length, num_threads);
+    matchfinder_ctx->sa_parent_link             = (uint64_t *)(void *)(matchfinder_ctx->esa_storage + ESA_MF_STORAGE_PADDING) + 0 * block_size;
+    matchfinder_ctx->plcp_leaf_link             = (uint32_t *)(void *)(matchfinder_ctx->esa_storage + ESA_MF_STORAGE_PADDING) + 2 * block_size + 2 * matchfinder_ctx->hot_intervals_size;
 }
 
-#endif
-
-void esa_matchfinder_destroy(void * mf)
+static int32_t esa_matchfinder_layout_block_size(const ESA_MF_CONTEXT * matchfinder_ctx, int32_t block_size)
 {
-    esa_matchfinder_free_ctx((ESA_MF_CONTEXT *)mf);
+    return matchfinder_ctx->fixed_layout ? matchfinder_ctx->max_block_size : block_size;
 }
 
-int32_t esa_matchfinder_parse(void * mf, const uint8_t * block, int32_t block_size)
+static void esa_matchfinder_attach_storage(ESA_MF_CONTEXT * matchfinder_ctx, int32_t * esa_storage, int32_t max_block_size)
 {
-    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+    matchfinder_ctx->esa_storage                = esa_storage;
+    matchfinder_ctx->max_block_size             = max_block_size;
 
-    if ((matchfinder_ctx == NULL) || (block == NULL) || (block_size < 0) || (block_size > matchfinder_ctx->max_block_size))
-    {
-        return ESA_MATCHFINDER_BAD_PARAMETER;
-    }
+    esa_matchfinder_set_block_layout(matchfinder_ctx, max_block_size);
+}
 
-    matchfinder_ctx->block_size = block_size;
-    memset(matchfinder_ctx->esa_storage + 0 * ESA_MF_STORAGE_PADDING + 0 * matchfinder_ctx->max_block_size + 0 * matchfinder_ctx->block_size, 0, ESA_MF_STORAGE_PADDING * sizeof(int32_t));
-    memset(matchfinder_ctx->esa_storage + 1 * ESA_MF_STORAGE_PADDING + 2 * matchfinder_ctx->max_block_size + 1 * matchfinder_ctx->block_size, 0, ESA_MF_STORAGE_PADDING * sizeof(int32_t));
+static ESA_MF_CONTEXT * esa_matchfinder_alloc_ctx(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads, esa_matchfinder_parallel_for parallel_for, void * parallel_for_context)
+{
+    num_threads                             = num_threads < ESA_MF_NUM_THREADS_MAX ? num_threads : ESA_MF_NUM_THREADS_MAX;
+    max_block_size                          = (max_block_size + ESA_MF_STORAGE_PADDING - 1) & (-ESA_MF_STORAGE_PADDING);
 
-    int32_t result = libsais_ctx(
-        matchfinder_ctx->libsais_ctx,
-        block,
-        (int32_t *)(void *)matchfinder_ctx->sa_parent_link,
-        matchfinder_ctx->block_size,
-        (2 * matchfinder_ctx->max_block_size) - matchfinder_ctx->block_size,
-        NULL);
+    ESA_MF_CONTEXT *    matchfinder_ctx     = (ESA_MF_CONTEXT *)esa_matchfinder_alloc_aligned(sizeof(ESA_MF_CONTEXT), ESA_MF_STORAGE_PADDING);
+    int32_t *           esa_storage         = (int32_t *)esa_matchfinder_alloc_pages(esa_matchfinder_storage_size(max_block_size));
 
-    if (result == ESA_MATCHFINDER_NO_ERROR)
-    {
 #if defined(_OPENMP)
-        result = libsais_plcp_omp(
-            block,
-            (int32_t *)(void *)matchfinder_ctx->sa_parent_link,
-            (int32_t *)(void *)matchfinder_ctx->plcp_leaf_link,
-            matchfinder_ctx->block_size,
-            matchfinder_ctx->num_threads);
+    void *              libsais_ctx         = parallel_for == NULL ? libsais_create_ctx_omp(num_threads) : libsais_create_ctx();
 #else
-        result = libsais_plcp(
-            block,
-            (int32_t *)(void *)matchfinder_ctx->sa_parent_link,
-            (int32_t *)(void *)matchfinder_ctx->plcp_leaf_link,
-            block_size);
+    void *              libsais_ctx         = libsais_create_ctx();
 #endif
 
-        if (result == ESA_MATCHFINDER_NO_ERROR)
-        {
-            esa_matchfinder_convert_inplace_32u_to_64u_omp(
-                (uint32_t *)(void *)matchfinder_ctx->sa_parent_link,
-                (uint64_t *)(void *)matchfinder_ctx->sa_parent_link,
-                matchfinder_ctx->block_size,
-                matchfinder_ctx->num_threads);
+    if (matchfinder_ctx != NULL && esa_storage != NULL && libsais_ctx != NULL)
+    {
+        matchfinder_ctx->libsais_ctx                = libsais_ctx;
 
-            esa_matchfinder_build_interval_tree_omp(
-                matchfinder_ctx->sa_parent_link,
-                matchfinder_ctx->plcp_leaf_link,
-                (uint64_t)matchfinder_ctx->min_match_length,
-                (uint64_t)matchfinder_ctx->max_match_length,
-                matchfinder_ctx->block_size,
-                matchfinder_ctx->num_threads,
-                matchfinder_ctx->threads);
+        matchfinder_ctx->parallel_for               = parallel_for;
+        matchfinder_ctx->parallel_for_context       = parallel_for_context;
+        matchfinder_ctx->thread_pool                = NULL;
 
-            esa_matchfinder_set_position(matchfinder_ctx, 0);
-        }
+        matchfinder_ctx->block                      = NULL;
+        matchfinder_ctx->dictionary                 = NULL;
+        matchfinder_ctx->delta_block                = NULL;
+        matchfinder_ctx->cursor_parent_link         = NULL;
+
+        matchfinder_ctx->query_intervals            = NULL;
+        matchfinder_ctx->query_ranks                = NULL;
+        matchfinder_ctx->query_bitmap               = NULL;
+        matchfinder_ctx->query_storage              = NULL;
+        matchfinder_ctx->query_words                = 0;
+        matchfinder_ctx->query_levels               = 0;
+
+        matchfinder_ctx->block_size                 = -1;
+        matchfinder_ctx->fixed_layout               = 0;
+        matchfinder_ctx->min_match_length           = min_match_length;
+        matchfinder_ctx->max_match_length           = max_match_length;
+        matchfinder_ctx->num_threads                = num_threads;
+        matchfinder_ctx->parse_num_threads          = num_threads;
+        matchfinder_ctx->sort_mode                  = ESA_MATCHFINDER_SORT_FULL;
+        matchfinder_ctx->isa                        = esa_matchfinder_detect_isa();
+
+        matchfinder_ctx->min_match_length_minus_1   = (uint64_t)matchfinder_ctx->min_match_length - 1;
+
+        esa_matchfinder_attach_storage(matchfinder_ctx, esa_storage, max_block_size);
+        esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)-1);
+
+        return matchfinder_ctx;
     }
 
-    return result;
-}
+    libsais_free_ctx(libsais_ctx);
 
-int32_t esa_matchfinder_get_position(void * mf)
-{
-    return (int32_t)((ESA_MF_CONTEXT *)mf)->position;
+    esa_matchfinder_free_pages(esa_storage, esa_matchfinder_storage_size(max_block_size));
+    esa_matchfinder_free_aligned(matchfinder_ctx);
+
+    return NULL;
 }
 
-int32_t esa_matchfinder_rewind(void * mf, int32_t position)
+static void esa_matchfinder_free_ctx(ESA_MF_CONTEXT * matchfinder_ctx)
 {
-    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
-
-    if ((matchfinder_ctx == NULL) || (position < 0) || (position >= matchfinder_ctx->block_size))
+    if (matchfinder_ctx != NULL)
     {
-        return ESA_MATCHFINDER_BAD_PARAMETER;
+        esa_matchfinder_destroy_thread_pool(matchfinder_ctx->thread_pool);
+        libsais_free_ctx(matchfinder_ctx->libsais_ctx);
+
+        esa_matchfinder_free_aligned(matchfinder_ctx->delta_block);
+        esa_matchfinder_free_aligned(matchfinder_ctx->cursor_parent_link);
+        esa_matchfinder_free_aligned(matchfinder_ctx->query_storage);
+        esa_matchfinder_free_pages(matchfinder_ctx->esa_storage, esa_matchfinder_storage_size(matchfinder_ctx->max_block_size));
+        esa_matchfinder_free_aligned(matchfinder_ctx);
     }
+}
 
-    if (matchfinder_ctx->position != (uint64_t)position)
+#if defined(ESA_MF_HAS_AVX512)
+
+static ESA_MF_TARGET_AVX512 ptrdiff_t esa_matchfinder_convert_right_to_left_32u_to_64u_avx512(uint32_t * S, uint64_t * D, ptrdiff_t i, ptrdiff_t j, int32_t stream)
+{
+    if (stream)
     {
-        if (matchfinder_ctx->position != 0)
+        for (; j > i && (((uintptr_t)&D[j]) & 63) != 0; j -= 1) { D[j - 1] = (uint64_t)S[j - 1]; }
+
+        for (; j - 16 >= i; j -= 16)
         {
-            for (ptrdiff_t thread = 0; thread < matchfinder_ctx->num_threads; thread += 1)
-            {
-                ptrdiff_t interval_tree_start   = matchfinder_ctx->threads[thread].interval_tree_start;
-                ptrdiff_t interval_tree_end     = matchfinder_ctx->threads[thread].interval_tree_end;
+            __m512i s = _mm512_loadu_si512((const void *)&S[j - 16]);
 
-                if (interval_tree_start < interval_tree_end)
-                {
-                    esa_matchfinder_reset_interval_tree_omp(
-                        matchfinder_ctx->sa_parent_link + interval_tree_start,
-                        interval_tree_end - interval_tree_start,
-                        matchfinder_ctx->num_threads);
-                }
-            }
+            _mm512_stream_si512((__m512i *)(void *)&D[j -  8], _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(s, 1)));
+            _mm512_stream_si512((__m512i *)(void *)&D[j - 16], _mm512_cvtepu32_epi64(_mm512_castsi512_si256(s)));
         }
 
-        if (position > 0)
-        {
-            esa_matchfinder_fast_forward(matchfinder_ctx->sa_parent_link, matchfinder_ctx->plcp_leaf_link, (uint64_t)position);
-        }
+        _mm_sfence();
+    }
 
-        esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)position);
+    for (; j - 16 >= i; j -= 16)
+    {
+        __m512i s = _mm512_loadu_si512((const void *)&S[j - 16]);
+
+        _mm512_storeu_si512((void *)&D[j -  8], _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(s, 1)));
+        _mm512_storeu_si512((void *)&D[j - 16], _mm512_cvtepu32_epi64(_mm512_castsi512_si256(s)));
     }
 
-    return ESA_MATCHFINDER_NO_ERROR;
+    return j;
 }
 
-ESA_MATCHFINDER_MATCH * esa_matchfinder_find_all_matches(void * mf, ESA_MATCHFINDER_MATCH * matches)
+static ESA_MF_TARGET_AVX512 ptrdiff_t esa_matchfinder_convert_left_to_right_32u_to_64u_avx512(uint32_t * ESA_MF_RESTRICT S, uint64_t * ESA_MF_RESTRICT D, ptrdiff_t i, ptrdiff_t j, int32_t stream)
 {
-    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
-
-    const ptrdiff_t                                 prefetch_distance   = 4;
-    const uint64_t                                  position            = matchfinder_ctx->position++;
-
-    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
-    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
-    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
-    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT         next_match          = matches;
-
-    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
-    esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
-
-    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
-    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-    uint64_t best_match             = (uint64_t)(uint32_t)-1;
-    uint64_t reference              = plcp_leaf_link[position];
-
-    while (reference != 0)
+    if (stream)
     {
-        const uint64_t interval     = sa_parent_link[reference];
-        const uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+        for (; i < j && (((uintptr_t)&D[i]) & 63) != 0; i += 1) { D[i] = (uint64_t)S[i]; }
 
-#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
-        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
-        {
-            *(uint64_t *)(void *)next_match = match;
-        }
-        else
-#endif
+        for (; i + 16 <= j; i += 16)
         {
-            next_match->length      = (int32_t)(match      );
-            next_match->offset      = (int32_t)(match >> 32);
+            _mm512_stream_si512((__m512i *)(void *)&D[i + 0], _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(const void *)&S[i + 0])));
+            _mm512_stream_si512((__m512i *)(void *)&D[i + 8], _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(const void *)&S[i + 8])));
         }
 
-        next_match                 += match > best_match;
-        best_match                  = match;
+        _mm_sfence();
+    }
 
-        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
-        reference                   = interval & ESA_MF_PARENT_MASK;
+    for (; i + 16 <= j; i += 16)
+    {
+        _mm512_storeu_si512((void *)&D[i + 0], _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(const void *)&S[i + 0])));
+        _mm512_storeu_si512((void *)&D[i + 8], _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(const void *)&S[i + 8])));
     }
 
-    return next_match;
+    return i;
 }
 
-ESA_MATCHFINDER_MATCH * esa_matchfinder_find_all_matches_in_window(void * mf, ESA_MATCHFINDER_MATCH * matches, uint64_t window_size)
+static ESA_MF_TARGET_AVX512 ptrdiff_t esa_matchfinder_reset_interval_tree_avx512(uint64_t * ESA_MF_RESTRICT sa_parent_link, ptrdiff_t i, ptrdiff_t j)
 {
-    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+    const __m512i mask = _mm512_set1_epi64((long long)(~ESA_MF_OFFSET_MASK));
 
-    const ptrdiff_t                                 prefetch_distance   = 4;
-    const uint64_t                                  position            = matchfinder_ctx->position++;
+    for (; i + 16 <= j; i += 16)
+    {
+        _mm512_storeu_si512((void *)&sa_parent_link[i + 0], _mm512_and_si512(_mm512_loadu_si512((const void *)&sa_parent_link[i + 0]), mask));
+        _mm512_storeu_si512((void *)&sa_parent_link[i + 8], _mm512_and_si512(_mm512_loadu_si512((const void *)&sa_parent_link[i + 8]), mask));
+    }
 
-    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
-    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
-    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
-    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT         next_match          = matches;
+    return i;
+}
 
-    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
-    esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+#endif
 
-    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
-    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-    uint64_t best_match             = (position > window_size ? (position - window_size) << 32 : 0) + (uint64_t)(uint32_t)-1;
-    uint64_t reference              = plcp_leaf_link[position];
+#if defined(ESA_MF_HAS_AVX2)
 
-    while (reference != 0)
+static ESA_MF_TARGET_AVX2 ptrdiff_t esa_matchfinder_convert_right_to_left_32u_to_64u_avx2(uint32_t * S, uint64_t * D, ptrdiff_t i, ptrdiff_t j, int32_t stream)
+{
+    if (stream)
     {
-        const uint64_t interval     = sa_parent_link[reference];
-        const uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+        for (; j > i && (((uintptr_t)&D[j]) & 31) != 0; j -= 1) { D[j - 1] = (uint64_t)S[j - 1]; }
 
-#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
-        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
-        {
-            *(uint64_t *)(void *)next_match = match;
-        }
-        else
-#endif
+        for (; j - 8 >= i; j -= 8)
         {
-            next_match->length      = (int32_t)(match      );
-            next_match->offset      = (int32_t)(match >> 32);
+            __m256i s = _mm256_loadu_si256((const __m256i *)(const void *)&S[j - 8]);
+
+            _mm256_stream_si256((__m256i *)(void *)&D[j - 4], _mm256_cvtepu32_epi64(_mm256_extracti128_si256(s, 1)));
+            _mm256_stream_si256((__m256i *)(void *)&D[j - 8], _mm256_cvtepu32_epi64(_mm256_castsi256_si128(s)));
         }
 
-        next_match                 += match > best_match;
-        best_match                  = match;
+        _mm_sfence();
+    }
 
-        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
-        reference                   = interval & ESA_MF_PARENT_MASK;
+    for (; j - 8 >= i; j -= 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(const void *)&S[j - 8]);
+
+        _mm256_storeu_si256((__m256i *)(void *)&D[j - 4], _mm256_cvtepu32_epi64(_mm256_extracti128_si256(s, 1)));
+        _mm256_storeu_si256((__m256i *)(void *)&D[j - 8], _mm256_cvtepu32_epi64(_mm256_castsi256_si128(s)));
     }
 
-    return next_match;
+    return j;
 }
 
-ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match(void * mf)
+static ESA_MF_TARGET_AVX2 ptrdiff_t esa_matchfinder_convert_left_to_right_32u_to_64u_avx2(uint32_t * ESA_MF_RESTRICT S, uint64_t * ESA_MF_RESTRICT D, ptrdiff_t i, ptrdiff_t j, int32_t stream)
 {
-    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+    if (stream)
+    {
+        for (; i < j && (((uintptr_t)&D[i]) & 31) != 0; i += 1) { D[i] = (uint64_t)S[i]; }
 
-    const ptrdiff_t                                 prefetch_distance   = 4;
-    const uint64_t                                  position            = matchfinder_ctx->position++;
+        for (; i + 8 <= j; i += 8)
+        {
+            _mm256_stream_si256((__m256i *)(void *)&D[i + 0], _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(const void *)&S[i + 0])));
+            _mm256_stream_si256((__m256i *)(void *)&D[i + 4], _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(const void *)&S[i + 4])));
+        }
 
-    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
-    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
-    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+        _mm_sfence();
+    }
 
-    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+    for (; i + 8 <= j; i += 8)
+    {
+        _mm256_storeu_si256((__m256i *)(void *)&D[i + 0], _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(const void *)&S[i + 0])));
+        _mm256_storeu_si256((__m256i *)(void *)&D[i + 4], _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(const void *)&S[i + 4])));
+    }
+
+    return i;
+}
+
+static ESA_MF_TARGET_AVX2 ptrdiff_t esa_matchfinder_reset_interval_tree_avx2(uint64_t * ESA_MF_RESTRICT sa_parent_link, ptrdiff_t i, ptrdiff_t j)
+{
+    const __m256i mask = _mm256_set1_epi64x((long long)(~ESA_MF_OFFSET_MASK));
+
+    for (; i + 8 <= j; i += 8)
+    {
+        _mm256_storeu_si256((__m256i *)(void *)&sa_parent_link[i + 0], _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(const void *)&sa_parent_link[i + 0]), mask));
+        _mm256_storeu_si256((__m256i *)(void *)&sa_parent_link[i + 4], _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(const void *)&sa_parent_link[i + 4]), mask));
+    }
+
+    return i;
+}
+
+#endif
+
+#if defined(ESA_MF_HAS_SSE2)
+
+static ptrdiff_t esa_matchfinder_convert_right_to_left_32u_to_64u_sse2(uint32_t * S, uint64_t * D, ptrdiff_t i, ptrdiff_t j)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; j - 4 >= i; j -= 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(const void *)&S[j - 4]);
+
+        _mm_storeu_si128((__m128i *)(void *)&D[j - 2], _mm_unpackhi_epi32(s, zero));
+        _mm_storeu_si128((__m128i *)(void *)&D[j - 4], _mm_unpacklo_epi32(s, zero));
+    }
+
+    return j;
+}
+
+#elif defined(ESA_MF_HAS_NEON)
+
+static ptrdiff_t esa_matchfinder_convert_right_to_left_32u_to_64u_neon(uint32_t * S, uint64_t * D, ptrdiff_t i, ptrdiff_t j)
+{
+    for (; j - 4 >= i; j -= 4)
+    {
+        uint32x4_t s = vld1q_u32(&S[j - 4]);
+
+        vst1q_u64(&D[j - 2], vmovl_u32(vget_high_u32(s)));
+        vst1q_u64(&D[j - 4], vmovl_u32(vget_low_u32(s)));
+    }
+
+    return j;
+}
+
+#endif
+
+static void esa_matchfinder_convert_right_to_left_32u_to_64u(uint32_t * S, uint64_t * D, ptrdiff_t omp_block_start, ptrdiff_t omp_block_size, int32_t isa, int32_t stream)
+{
+    ptrdiff_t i = omp_block_start, j = omp_block_start + omp_block_size;
+
+#if defined(ESA_MF_HAS_AVX512)
+    if (isa == ESA_MATCHFINDER_ISA_AVX512) { j = esa_matchfinder_convert_right_to_left_32u_to_64u_avx512(S, D, i, j, stream); }
+#endif
+#if defined(ESA_MF_HAS_AVX2)
+    if (isa == ESA_MATCHFINDER_ISA_AVX2) { j = esa_matchfinder_convert_right_to_left_32u_to_64u_avx2(S, D, i, j, stream); }
+#endif
+#if defined(ESA_MF_HAS_SSE2)
+    j = esa_matchfinder_convert_right_to_left_32u_to_64u_sse2(S, D, i, j);
+#elif defined(ESA_MF_HAS_NEON)
+    j = esa_matchfinder_convert_right_to_left_32u_to_64u_neon(S, D, i, j);
+#endif
+
+    ESA_MF_UNUSED(isa); ESA_MF_UNUSED(stream);
+
+    for (j -= 1; j >= i; j -= 1) { D[j] = (uint64_t)S[j]; }
+}
+
+static void esa_matchfinder_convert_left_to_right_32u_to_64u(uint32_t * ESA_MF_RESTRICT S, uint64_t * ESA_MF_RESTRICT D, ptrdiff_t omp_block_start, ptrdiff_t omp_block_size, int32_t isa, int32_t stream)
+{
+    ptrdiff_t i = omp_block_start, j = omp_block_start + omp_block_size;
+
+#if defined(ESA_MF_HAS_AVX512)
+    if (isa == ESA_MATCHFINDER_ISA_AVX512) { i = esa_matchfinder_convert_left_to_right_32u_to_64u_avx512(S, D, i, j, stream); }
+#endif
+#if defined(ESA_MF_HAS_AVX2)
+    if (isa == ESA_MATCHFINDER_ISA_AVX2) { i = esa_matchfinder_convert_left_to_right_32u_to_64u_avx2(S, D, i, j, stream); }
+#endif
+
+    ESA_MF_UNUSED(isa); ESA_MF_UNUSED(stream);
+
+    for (; i < j; i += 1) { D[i] = (uint64_t)S[i]; }
+}
+
+typedef struct ESA_MF_CONVERT_TASK
+{
+    uint32_t *              S;
+    uint64_t *              D;
+    ptrdiff_t               block_start;
+    ptrdiff_t               block_size;
+    int32_t                 isa;
+    int32_t                 stream;
+} ESA_MF_CONVERT_TASK;
+
+static void esa_matchfinder_convert_left_to_right_32u_to_64u_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_CONVERT_TASK * convert_task = (ESA_MF_CONVERT_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (convert_task->block_size / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+    ptrdiff_t omp_block_size      = task < num_tasks - 1 ? omp_block_stride : convert_task->block_size - omp_block_start;
+
+    esa_matchfinder_convert_left_to_right_32u_to_64u(convert_task->S, convert_task->D, convert_task->block_start + omp_block_start, omp_block_size, convert_task->isa, convert_task->stream);
+}
+
+static void esa_matchfinder_convert_inplace_32u_to_64u_omp(const ESA_MF_CONTEXT * matchfinder_ctx, uint32_t * S, uint64_t * D, ptrdiff_t n, ptrdiff_t num_threads)
+{
+    int32_t stream = n >= ESA_MF_STREAM_THRESHOLD;
+
+    ptrdiff_t num_tasks;
+    while ((num_tasks = esa_matchfinder_num_tasks(num_threads, n >> 1, ESA_MF_CONVERT_GRAIN_SIZE)) > 1)
+    {
+        ptrdiff_t block_size = n >> 1; n -= block_size;
+
+        ESA_MF_CONVERT_TASK convert_task = { S, D, n, block_size, matchfinder_ctx->isa, stream };
+        esa_matchfinder_run_tasks(matchfinder_ctx, num_tasks, esa_matchfinder_convert_left_to_right_32u_to_64u_task, &convert_task);
+    }
+
+    esa_matchfinder_convert_right_to_left_32u_to_64u(S, D, 0, n, matchfinder_ctx->isa, stream);
+}
+
+static void esa_matchfinder_reset_interval_tree(uint64_t * ESA_MF_RESTRICT sa_parent_link, ptrdiff_t omp_block_start, ptrdiff_t omp_block_size, int32_t isa)
+{
+    ptrdiff_t i = omp_block_start, j = omp_block_start + omp_block_size;
+
+#if defined(ESA_MF_HAS_AVX512)
+    if (isa == ESA_MATCHFINDER_ISA_AVX512) { i = esa_matchfinder_reset_interval_tree_avx512(sa_parent_link, i, j); }
+#endif
+#if defined(ESA_MF_HAS_AVX2)
+    if (isa == ESA_MATCHFINDER_ISA_AVX2) { i = esa_matchfinder_reset_interval_tree_avx2(sa_parent_link, i, j); }
+#endif
+
+    ESA_MF_UNUSED(isa);
+
+    for (; i < j; i += 1) { sa_parent_link[i] &= (~ESA_MF_OFFSET_MASK); }
+}
+
+typedef struct ESA_MF_RESET_TASK
+{
+    uint64_t *              sa_parent_link;
+    ptrdiff_t               n;
+    int32_t                 isa;
+} ESA_MF_RESET_TASK;
+
+static void esa_matchfinder_reset_interval_tree_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_RESET_TASK * reset_task = (ESA_MF_RESET_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (reset_task->n / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+    ptrdiff_t omp_block_size      = task < num_tasks - 1 ? omp_block_stride : reset_task->n - omp_block_start;
+
+    esa_matchfinder_reset_interval_tree(reset_task->sa_parent_link, omp_block_start, omp_block_size, reset_task->isa);
+}
+
+static void esa_matchfinder_reset_interval_tree_omp(const ESA_MF_CONTEXT * matchfinder_ctx, uint64_t * ESA_MF_RESTRICT sa_parent_link, ptrdiff_t n, ptrdiff_t num_threads)
+{
+    ESA_MF_RESET_TASK reset_task = { sa_parent_link, n, matchfinder_ctx->isa };
+    esa_matchfinder_run_tasks(matchfinder_ctx, esa_matchfinder_num_tasks(num_threads, n, ESA_MF_RESET_GRAIN_SIZE), esa_matchfinder_reset_interval_tree_task, &reset_task);
+}
+
+static void esa_matchfinder_apply_deferred_updates(ESA_MF_CONTEXT * ESA_MF_RESTRICT matchfinder_ctx)
+{
+    uint64_t * ESA_MF_RESTRICT const sa_parent_link = matchfinder_ctx->sa_parent_link;
+
+    for (uint64_t index = matchfinder_ctx->deferred_count; index-- != 0; )
+    {
+        const uint64_t new_offset       = (matchfinder_ctx->deferred_updates[index] >> 32) << ESA_MF_OFFSET_SHIFT;
+        uint64_t reference              = (uint32_t)matchfinder_ctx->deferred_updates[index];
+        uint64_t interval               = sa_parent_link[reference];
+
+        while ((interval & ESA_MF_OFFSET_MASK) < new_offset)
+        {
+            sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+            reference                   = interval & ESA_MF_PARENT_MASK;
+            interval                    = sa_parent_link[reference];
+        }
+    }
+
+    matchfinder_ctx->deferred_count     = 0;
+    matchfinder_ctx->deferred_lcp       = 0;
+}
+
+static void esa_matchfinder_fast_forward
+(
+    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
+    uint32_t * ESA_MF_RESTRICT  plcp_leaf_link,
+    uint64_t                    target_position
+)
+{
+    const uint64_t  prefetch_distance   = 32;
+    uint64_t        position            = target_position - 1;
+
+    for (; position >= prefetch_distance; position -= 1)
+    {
+        esa_matchfinder_prefetchr(&plcp_leaf_link[position - 2 * prefetch_distance]);
+        esa_matchfinder_prefetchw(&sa_parent_link[plcp_leaf_link[position - prefetch_distance]]);
+
+        const uint64_t offset           = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+        uint64_t reference              = plcp_leaf_link[position];
+        uint64_t interval               = sa_parent_link[reference];
+
+        while ((interval & ESA_MF_OFFSET_MASK) == 0)
+        {
+            sa_parent_link[reference]   = interval + offset;
+            reference                   = (uint32_t)interval;
+            interval                    = sa_parent_link[reference];
+        }
+    }
+
+    for (; position > 0; position -= 1)
+    {
+        const uint64_t offset           = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+        uint64_t reference              = plcp_leaf_link[position];
+        uint64_t interval               = sa_parent_link[reference];
+
+        while ((interval & ESA_MF_OFFSET_MASK) == 0)
+        {
+            sa_parent_link[reference]   = interval + offset;
+            reference                   = (uint32_t)interval;
+            interval                    = sa_parent_link[reference];
+        }
+    }
+}
+
+static uint64_t esa_matchfinder_compute_lcp(const uint8_t * ESA_MF_RESTRICT T, uint64_t p, uint64_t q, uint64_t n, uint64_t max_lcp, uint64_t l)
+{
+    if (q == (uint64_t)-1)
+    {
+        return 0;
+    }
+
+    uint64_t m = n - (p > q ? p : q); m = m < max_lcp ? m : max_lcp;
+
+#if defined(ESA_MF_HAS_SSE2) || defined(ESA_MF_HAS_NEON)
+    if (l == 0 && m >= 8)
+    {
+        uint64_t x, y; memcpy(&x, &T[p], sizeof(uint64_t)); memcpy(&y, &T[q], sizeof(uint64_t));
+
+        if (x != y)
+        {
+            return esa_matchfinder_ctz64(x ^ y) >> 3;
+        }
+
+        l = 8;
+    }
+
+    while (l + 16 <= m)
+    {
+#if defined(ESA_MF_HAS_SSE2)
+        uint64_t mask = (uint64_t)(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(const void *)&T[p + l]), _mm_loadu_si128((const __m128i *)(const void *)&T[q + l]))) ^ 0xffff);
+
+        if (mask != 0)
+        {
+            return l + esa_matchfinder_ctz64(mask);
+        }
+#else
+        uint8x16_t  equal   = vceqq_u8(vld1q_u8(&T[p + l]), vld1q_u8(&T[q + l]));
+        uint64_t    mask    = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+
+        if (mask != 0)
+        {
+            return l + (esa_matchfinder_ctz64(mask) >> 2);
+        }
+#endif
+
+        l += 16;
+    }
+#endif
+
+    while (l + 8 <= m)
+    {
+        uint64_t x, y; memcpy(&x, &T[p + l], sizeof(uint64_t)); memcpy(&y, &T[q + l], sizeof(uint64_t));
+
+        if (x != y)
+        {
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+            return l + (esa_matchfinder_ctz64(x ^ y) >> 3);
+#else
+            break;
+#endif
+        }
+
+        l += 8;
+    }
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+    if (l < m && m >= 8)
+    {
+        uint64_t x, y; memcpy(&x, &T[p + m - 8], sizeof(uint64_t)); memcpy(&y, &T[q + m - 8], sizeof(uint64_t));
+
+        return x == y ? m : m - 8 + (esa_matchfinder_ctz64(x ^ y) >> 3);
+    }
+#endif
+
+    while (l < m && T[p + l] == T[q + l]) { l += 1; }
+
+    return l;
+}
+
+typedef struct ESA_MF_BUILD_PROFILE
+{
+    ptrdiff_t               count;
+    uint64_t                min_lcp;
+    uint64_t                boundary_pos;
+    uint64_t                lcps[ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+    ptrdiff_t               positions[ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+
+    ptrdiff_t               open_count;
+    uint64_t                open_intervals[ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+
+    ptrdiff_t               pushed_count;
+    uint64_t                pushed_intervals[ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+    ptrdiff_t               pushed_positions[ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+} ESA_MF_BUILD_PROFILE;
+
+static void esa_matchfinder_build_interval_tree
+(
+    const uint8_t * ESA_MF_RESTRICT T,
+    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
+    uint32_t * ESA_MF_RESTRICT  plcp_leaf_link,
+    uint64_t                    min_match_length,
+    uint64_t                    max_match_length,
+    ptrdiff_t                   n,
+    ptrdiff_t                   omp_block_start,
+    ptrdiff_t                   omp_block_size,
+    ptrdiff_t                   hot_block_start,
+    ptrdiff_t                   hot_block_size,
+    ptrdiff_t                   convert_start,
+    int32_t                     isa,
+    const ESA_MF_BUILD_PROFILE * profile,
+    ESA_MF_THREAD_STATE *       thread_state
+)
+{
+    uint64_t intervals[2 * ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+
+    const ptrdiff_t             prefetch_distance       = 32;
+    uint64_t * ESA_MF_RESTRICT  stack                   = intervals;
+    uint64_t                    top_interval            = stack[0] = 0;
+    ptrdiff_t                   pushed_count            = profile != NULL ? profile->pushed_count : 0;
+    ptrdiff_t                   pushed_index            = 0;
+    ptrdiff_t                   pushed_position         = pushed_count > 0 ? profile->pushed_positions[0] : -1;
+    uint64_t                    next_interval_index     = (uint64_t)(omp_block_start + omp_block_size - 1);
+    uint64_t                    next_hot_interval_index = (uint64_t)(hot_block_start + hot_block_size - 1 - pushed_count);
+    const uint64_t              hot_interval_index_min  = (uint64_t)hot_block_start;
+
+    const uint64_t              boundary_pos            = profile != NULL ? profile->boundary_pos : (uint64_t)-1;
+    const uint64_t              max_lcp                 = max_match_length;
+
+    uint64_t                    last_next_pos           = 0;
+    uint64_t                    last_prev_pos           = 0;
+    uint64_t                    last_lcp                = 0;
+
+    for (ptrdiff_t k = 0; profile != NULL && k < profile->open_count; k += 1)
+    {
+        stack[1] = top_interval = profile->open_intervals[k]; stack += 1;
+    }
+
+    min_match_length -= 1;
+    max_match_length -= min_match_length;
+
+    for (ptrdiff_t i = omp_block_start + omp_block_size - 1; i >= omp_block_start; i -= 1)
+    {
+        if (i - 2 * prefetch_distance < convert_start && convert_start > omp_block_start)
+        {
+            ptrdiff_t convert_size = convert_start - omp_block_start < ESA_MF_CONVERT_CHUNK_SIZE ? convert_start - omp_block_start : ESA_MF_CONVERT_CHUNK_SIZE;
+
+            convert_start -= convert_size;
+            esa_matchfinder_convert_right_to_left_32u_to_64u((uint32_t *)(void *)sa_parent_link, sa_parent_link, convert_start, convert_size, isa, 0);
+        }
+
+        esa_matchfinder_prefetchr(&sa_parent_link[i - 2 * prefetch_distance]);
+
+        esa_matchfinder_prefetchr(&T[sa_parent_link[i - prefetch_distance]]);
+        esa_matchfinder_prefetchw(&plcp_leaf_link[sa_parent_link[i - prefetch_distance]]);
+        esa_matchfinder_prefetchw(&sa_parent_link[next_interval_index - prefetch_distance]);
+
+        uint64_t next_pos                   =  sa_parent_link[i];
+        uint64_t prev_pos                   =  i > omp_block_start ? sa_parent_link[i - 1] : boundary_pos;
+        uint64_t shift                      =  next_pos - last_next_pos;
+        uint64_t known_lcp                  =  0;
+
+        if (prev_pos - last_prev_pos == shift && shift - 1 < last_lcp) { known_lcp = last_lcp - shift; }
+
+        last_next_pos                       =  next_pos;
+        last_prev_pos                       =  prev_pos;
+        last_lcp                            =  esa_matchfinder_compute_lcp(T, next_pos, prev_pos, (uint64_t)n, max_lcp, known_lcp);
+
+        uint64_t next_lcp                   =  last_lcp - min_match_length;
+
+        if ((int64_t)next_lcp < 0)          {  next_lcp = 0; }
+        if (next_lcp > max_match_length)    {  next_lcp = max_match_length; }
+
+        uint64_t next_hot                   =  (next_lcp <= ESA_MF_HOT_INTERVALS_MAX_LCP) & (next_hot_interval_index >= hot_interval_index_min);
+        uint64_t next_cold                  =  next_hot ^ 1;
+        uint64_t next_interval              =  (next_lcp << ESA_MF_LCP_SHIFT) + (next_hot ? next_hot_interval_index : next_interval_index);
+        uint64_t top_interval_lcp           =  top_interval >> ESA_MF_LCP_SHIFT;
+
+        if (i == pushed_position)
+        {
+            next_interval                   =  profile->pushed_intervals[pushed_index];
+            next_hot                        =  0;
+            next_cold                       =  0;
+            pushed_index                    += 1;
+            pushed_position                 =  pushed_index < pushed_count ? profile->pushed_positions[pushed_index] : -1;
+        }
+
+        stack[1]                            =  next_interval;
+        top_interval                        =  next_lcp > top_interval_lcp ? next_interval : top_interval;
+        next_interval_index                 -= (next_lcp > top_interval_lcp) & (next_cold   );
+        next_hot_interval_index             -= (next_lcp > top_interval_lcp) & (next_hot    );
+        stack                               += next_lcp > top_interval_lcp;
+
+        plcp_leaf_link[next_pos]            =  (uint32_t)top_interval;
+
+        while (next_lcp < top_interval_lcp)
+        {
+            uint64_t closed_interval        =  top_interval;
+            
+            stack                           =  stack - 1;
+            top_interval                    =  stack[0];
+            top_interval_lcp                =  top_interval >> ESA_MF_LCP_SHIFT;
+
+            stack[1]                        =  next_interval;
+            top_interval                    =  next_lcp > top_interval_lcp ? next_interval : top_interval;
+            next_interval_index             -= (next_lcp > top_interval_lcp) & (next_cold   );
+            next_hot_interval_index         -= (next_lcp > top_interval_lcp) & (next_hot    );
+            stack                           += next_lcp > top_interval_lcp;
+            
+            sa_parent_link[(uint32_t)closed_interval] = (uint32_t)top_interval + (closed_interval & ESA_MF_LCP_MASK);
+        }
+    }
+
+    thread_state->interval_tree_start       = (ptrdiff_t)(next_interval_index + 1);
+    thread_state->interval_tree_end         = omp_block_start + omp_block_size;
+    thread_state->hot_interval_tree_start   = (ptrdiff_t)(next_hot_interval_index + 1);
+    thread_state->hot_interval_tree_end     = hot_block_start + hot_block_size;
+}
+
+static ptrdiff_t esa_matchfinder_find_breakpoint
+(
+    const uint8_t * ESA_MF_RESTRICT T,
+    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
+    uint64_t                    min_match_length,
+    ptrdiff_t                   n,
+    ptrdiff_t                   omp_block_start,
+    ptrdiff_t                   omp_block_size
+)
+{
+    const ptrdiff_t prefetch_distance = 32;
+
+    for (ptrdiff_t i = omp_block_start + omp_block_size - 1; i >= omp_block_start; i -= 1)
+    {
+        esa_matchfinder_prefetchr(&sa_parent_link[i - 2 * prefetch_distance]);
+        esa_matchfinder_prefetchr(&T[sa_parent_link[i - prefetch_distance]]);
+
+        if (esa_matchfinder_compute_lcp(T, sa_parent_link[i], i > 0 ? sa_parent_link[i - 1] : (uint64_t)-1, (uint64_t)n, min_match_length, 0) < min_match_length)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void esa_matchfinder_find_profile
+(
+    const uint8_t * ESA_MF_RESTRICT T,
+    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
+    uint64_t                    min_match_length,
+    uint64_t                    max_match_length,
+    ptrdiff_t                   n,
+    ptrdiff_t                   omp_block_start,
+    ptrdiff_t                   omp_block_size,
+    ESA_MF_BUILD_PROFILE *      profile
+)
+{
+    const ptrdiff_t prefetch_distance = 32;
+
+    ptrdiff_t   count   = 0;
+    uint64_t    min_lcp = (uint64_t)-1;
+    uint64_t    max_lcp = max_match_length;
+
+    profile->boundary_pos = omp_block_start > 0 ? sa_parent_link[omp_block_start - 1] : (uint64_t)-1;
+
+    min_match_length -= 1;
+    max_match_length -= min_match_length;
+
+    for (ptrdiff_t i = omp_block_start; i < omp_block_start + omp_block_size; i += 1)
+    {
+        esa_matchfinder_prefetchr(&sa_parent_link[i + 2 * prefetch_distance]);
+        esa_matchfinder_prefetchr(&T[sa_parent_link[i + prefetch_distance]]);
+
+        uint64_t prev_pos                   =  i > 0 ? sa_parent_link[i - 1] : (uint64_t)-1;
+        uint64_t next_lcp                   =  esa_matchfinder_compute_lcp(T, sa_parent_link[i], prev_pos, (uint64_t)n, max_lcp, 0) - min_match_length;
+
+        if ((int64_t)next_lcp < 0)          {  next_lcp = 0; }
+        if (next_lcp > max_match_length)    {  next_lcp = max_match_length; }
+
+        if (next_lcp < min_lcp)
+        {
+            min_lcp = next_lcp; if (min_lcp == 0) { break; }
+
+            profile->lcps[count] = next_lcp; profile->positions[count] = i; count += 1;
+        }
+        else if (next_lcp == min_lcp)
+        {
+            profile->positions[count - 1] = i;
+        }
+    }
+
+    profile->count          = count;
+    profile->min_lcp        = min_lcp;
+    profile->open_count     = 0;
+    profile->pushed_count   = 0;
+}
+
+static int32_t esa_matchfinder_link_profiles(ESA_MF_BUILD_PROFILE * profiles, ptrdiff_t num_threads, ptrdiff_t n, ptrdiff_t hot_intervals_size)
+{
+    ptrdiff_t hot_block_stride = hot_intervals_size / num_threads;
+
+    for (ptrdiff_t thread = num_threads - 1; thread > 0; thread -= 1)
+    {
+        ESA_MF_BUILD_PROFILE * ESA_MF_RESTRICT profile      = &profiles[thread];
+        ESA_MF_BUILD_PROFILE * ESA_MF_RESTRICT next_profile = &profiles[thread - 1];
+
+        ptrdiff_t next_hot_interval_index = n + thread * hot_block_stride + hot_block_stride - 1;
+        ptrdiff_t open_count = 0, open_index = 0;
+
+        while (open_index < profile->open_count && (profile->open_intervals[open_index] >> ESA_MF_LCP_SHIFT) < profile->min_lcp)
+        {
+            next_profile->open_intervals[open_count++] = profile->open_intervals[open_index++];
+        }
+
+        for (ptrdiff_t k = profile->count - 1; k >= 0; k -= 1)
+        {
+            if (profile->lcps[k] == profile->min_lcp && open_index < profile->open_count && (profile->open_intervals[open_index] >> ESA_MF_LCP_SHIFT) == profile->lcps[k])
+            {
+                next_profile->open_intervals[open_count++] = profile->open_intervals[open_index++];
+                continue;
+            }
+
+            if (profile->pushed_count == hot_block_stride)
+            {
+                return 0;
+            }
+
+            uint64_t interval = (profile->lcps[k] << ESA_MF_LCP_SHIFT) + (uint64_t)(next_hot_interval_index - profile->pushed_count);
+
+            profile->pushed_intervals[profile->pushed_count] = interval;
+            profile->pushed_positions[profile->pushed_count] = profile->positions[k];
+            profile->pushed_count += 1;
+
+            next_profile->open_intervals[open_count++] = interval;
+        }
+
+        next_profile->open_count = open_count;
+    }
+
+    return 1;
+}
+
+typedef struct ESA_MF_BUILD_TASK
+{
+    const uint8_t *         T;
+    uint64_t *              sa_parent_link;
+    uint32_t *              plcp_leaf_link;
+    uint64_t                min_match_length;
+    uint64_t                max_match_length;
+    ptrdiff_t               n;
+    ptrdiff_t               hot_intervals_size;
+    ESA_MF_THREAD_STATE *   threads;
+    ESA_MF_BUILD_PROFILE *  profiles;
+    int32_t                 isa;
+    ptrdiff_t               breakpoints[ESA_MF_NUM_THREADS_MAX];
+} ESA_MF_BUILD_TASK;
+
+static void esa_matchfinder_find_profile_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_BUILD_TASK * build_task = (ESA_MF_BUILD_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (build_task->n / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+    ptrdiff_t omp_block_size      = task < num_tasks - 1 ? omp_block_stride : build_task->n - omp_block_start;
+
+    esa_matchfinder_find_profile(
+        build_task->T,
+        build_task->sa_parent_link,
+        build_task->min_match_length,
+        build_task->max_match_length,
+        build_task->n,
+        omp_block_start,
+        omp_block_size,
+        &build_task->profiles[task]);
+}
+
+static void esa_matchfinder_build_interval_tree_profile_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_BUILD_TASK * build_task = (ESA_MF_BUILD_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (build_task->n / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+    ptrdiff_t omp_block_size      = task < num_tasks - 1 ? omp_block_stride : build_task->n - omp_block_start;
+    ptrdiff_t hot_block_stride    = build_task->hot_intervals_size / num_tasks;
+    ptrdiff_t hot_block_start     = build_task->n + task * hot_block_stride;
+
+    esa_matchfinder_build_interval_tree(
+        build_task->T,
+        build_task->sa_parent_link,
+        build_task->plcp_leaf_link,
+        build_task->min_match_length,
+        build_task->max_match_length,
+        build_task->n,
+        omp_block_start,
+        omp_block_size,
+        hot_block_start,
+        hot_block_stride,
+        omp_block_start,
+        build_task->isa,
+        &build_task->profiles[task],
+        &build_task->threads[task]);
+}
+
+static void esa_matchfinder_find_breakpoint_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_BUILD_TASK * build_task = (ESA_MF_BUILD_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (build_task->n / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+
+    build_task->breakpoints[task] = task < num_tasks - 1
+        ? esa_matchfinder_find_breakpoint(build_task->T, build_task->sa_parent_link, build_task->min_match_length, build_task->n, omp_block_start, omp_block_stride)
+        : build_task->n;
+}
+
+static void esa_matchfinder_build_interval_tree_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_BUILD_TASK * build_task = (ESA_MF_BUILD_TASK *)task_context;
+
+    ptrdiff_t hot_block_stride    = build_task->hot_intervals_size / num_tasks;
+    ptrdiff_t hot_block_start     = build_task->n + task * hot_block_stride;
+
+    if (build_task->breakpoints[task] != -1)
+    {
+        ptrdiff_t omp_block_end       = build_task->breakpoints[task];
+        ptrdiff_t omp_block_start     = 0;
+
+        for (ptrdiff_t thread = task - 1; thread >= 0; thread -= 1)
+        { 
+            if (build_task->breakpoints[thread] != -1) { omp_block_start = build_task->breakpoints[thread]; break; }
+        }
+
+        if (omp_block_start < omp_block_end)
+        {
+            esa_matchfinder_build_interval_tree(
+                build_task->T,
+                build_task->sa_parent_link,
+                build_task->plcp_leaf_link,
+                build_task->min_match_length,
+                build_task->max_match_length,
+                build_task->n,
+                omp_block_start,
+                omp_block_end - omp_block_start,
+                hot_block_start,
+                hot_block_stride,
+                omp_block_start,
+                build_task->isa,
+                NULL,
+                &build_task->threads[task]);
+        }
+    }
+}
+
+static void esa_matchfinder_build_interval_tree_omp
+(
+    const ESA_MF_CONTEXT *      matchfinder_ctx,
+    const uint8_t * ESA_MF_RESTRICT T,
+    uint64_t * ESA_MF_RESTRICT  sa_parent_link,
+    uint32_t * ESA_MF_RESTRICT  plcp_leaf_link,
+    uint64_t                    min_match_length,
+    uint64_t                    max_match_length,
+    ptrdiff_t                   n,
+    ptrdiff_t                   num_threads,
+    ESA_MF_THREAD_STATE *       threads
+)
+{
+    ptrdiff_t hot_intervals_size = (ptrdiff_t)ESA_MF_PARENT_MAX + 1 - n;
+    hot_intervals_size = hot_intervals_size < matchfinder_ctx->hot_intervals_size ? hot_intervals_size : matchfinder_ctx->hot_intervals_size;
+
+    for (ptrdiff_t thread = 0; thread < matchfinder_ctx->num_threads; thread += 1)
+    {
+        threads[thread].interval_tree_start     = 0;
+        threads[thread].interval_tree_end       = 0;
+        threads[thread].hot_interval_tree_start = 0;
+        threads[thread].hot_interval_tree_end   = 0;
+    }
+
+    ptrdiff_t num_tasks = esa_matchfinder_num_tasks(num_threads, n, ESA_MF_BUILD_GRAIN_SIZE);
+
+    if (num_tasks == 1)
+    {
+        esa_matchfinder_build_interval_tree(
+            T,
+            sa_parent_link,
+            plcp_leaf_link,
+            min_match_length,
+            max_match_length,
+            n,
+            0,
+            n,
+            n,
+            hot_intervals_size,
+            n,
+            matchfinder_ctx->isa,
+            NULL,
+            &threads[0]);
+    }
+    else
+    {
+        ESA_MF_BUILD_TASK build_task;
+
+        esa_matchfinder_convert_inplace_32u_to_64u_omp(matchfinder_ctx, (uint32_t *)(void *)sa_parent_link, sa_parent_link, n, num_threads);
+
+        build_task.T                    = T;
+        build_task.sa_parent_link       = sa_parent_link;
+        build_task.plcp_leaf_link       = plcp_leaf_link;
+        build_task.min_match_length     = min_match_length;
+        build_task.max_match_length     = max_match_length;
+        build_task.n                    = n;
+        build_task.hot_intervals_size   = hot_intervals_size;
+        build_task.threads              = threads;
+        build_task.isa                  = matchfinder_ctx->isa;
+        build_task.profiles             = (ESA_MF_BUILD_PROFILE *)esa_matchfinder_alloc_aligned((size_t)num_tasks * sizeof(ESA_MF_BUILD_PROFILE), ESA_MF_STORAGE_PADDING);
+
+        if (build_task.profiles != NULL)
+        {
+            esa_matchfinder_run_tasks(matchfinder_ctx, num_tasks, esa_matchfinder_find_profile_task, &build_task);
+        }
+
+        if (build_task.profiles != NULL && esa_matchfinder_link_profiles(build_task.profiles, num_tasks, n, hot_intervals_size))
+        {
+            esa_matchfinder_run_tasks(matchfinder_ctx, num_tasks, esa_matchfinder_build_interval_tree_profile_task, &build_task);
+        }
+        else
+        {
+            esa_matchfinder_run_tasks(matchfinder_ctx, num_tasks, esa_matchfinder_find_breakpoint_task, &build_task);
+            esa_matchfinder_run_tasks(matchfinder_ctx, num_tasks, esa_matchfinder_build_interval_tree_task, &build_task);
+        }
+
+        esa_matchfinder_free_aligned(build_task.profiles);
+    }
+
+    {
+        sa_parent_link[0] = ESA_MF_OFFSET_MASK;
+    }
+}
+
+static void esa_matchfinder_build_query_intervals
+(
+    const uint64_t * ESA_MF_RESTRICT    sa_parent_link,
+    const uint32_t * ESA_MF_RESTRICT    plcp_leaf_link,
+    const uint32_t * ESA_MF_RESTRICT    SA,
+    uint32_t * ESA_MF_RESTRICT          query_intervals,
+    ptrdiff_t                           n,
+    ptrdiff_t                           num_intervals
+)
+{
+    for (ptrdiff_t i = 0; i < num_intervals; i += 1)
+    {
+        query_intervals[2 * i + 0] = UINT32_MAX;
+        query_intervals[2 * i + 1] = 0;
+    }
+
+    for (ptrdiff_t i = 0; i < n; i += 1)
+    {
+        uint64_t reference = plcp_leaf_link[SA[i]];
+
+        while (reference != 0 && query_intervals[2 * reference + 0] == UINT32_MAX)
+        {
+            query_intervals[2 * reference + 0] = (uint32_t)i;
+            reference = sa_parent_link[reference] & ESA_MF_PARENT_MASK;
+        }
+    }
+
+    for (ptrdiff_t i = n - 1; i >= 0; i -= 1)
+    {
+        uint64_t reference = plcp_leaf_link[SA[i]];
+
+        while (reference != 0 && query_intervals[2 * reference + 1] == 0)
+        {
+            query_intervals[2 * reference + 1] = (uint32_t)(i + 1);
+            reference = sa_parent_link[reference] & ESA_MF_PARENT_MASK;
+        }
+    }
+}
+
+static void esa_matchfinder_build_query_wavelet_matrix(ESA_MF_CONTEXT * matchfinder_ctx, uint32_t * SA, uint32_t * buffer, ptrdiff_t n)
+{
+    const int64_t   query_words     = (int64_t)(n >> 6) + 1;
+    int64_t         query_levels    = 1;
+
+    while (((ptrdiff_t)1 << query_levels) < n) { query_levels += 1; }
+
+    for (int64_t level = 0; level < query_levels; level += 1)
+    {
+        uint64_t * ESA_MF_RESTRICT  bitmap  = matchfinder_ctx->query_bitmap + level * query_words;
+        uint32_t * ESA_MF_RESTRICT  ranks   = matchfinder_ctx->query_ranks  + level * query_words;
+        const int64_t               shift   = query_levels - level - 1;
+
+        memset(bitmap, 0, (size_t)query_words * sizeof(uint64_t));
+
+        ptrdiff_t zeros = 0, ones = 0;
+        for (ptrdiff_t i = 0; i < n; i += 1)
+        {
+            if ((SA[i] >> shift) & 1) { bitmap[i >> 6] |= (uint64_t)1 << (i & 63); ones += 1; } else { zeros += 1; }
+        }
+
+        uint32_t rank = 0;
+        for (int64_t word = 0; word < query_words; word += 1)
+        {
+            ranks[word] = rank; rank += (uint32_t)esa_matchfinder_popcount64(bitmap[word]);
+        }
+
+        ptrdiff_t next_zero = 0, next_one = zeros;
+        for (ptrdiff_t i = 0; i < n; i += 1)
+        {
+            if ((SA[i] >> shift) & 1) { buffer[next_one++] = SA[i]; } else { buffer[next_zero++] = SA[i]; }
+        }
+
+        matchfinder_ctx->query_zeros[level] = (uint64_t)zeros;
+
+        { uint32_t * swap = SA; SA = buffer; buffer = swap; }
+    }
+
+    matchfinder_ctx->query_words    = query_words;
+    matchfinder_ctx->query_levels   = query_levels;
+}
+
+static int32_t esa_matchfinder_alloc_query_index(ESA_MF_CONTEXT * matchfinder_ctx)
+{
+    if (matchfinder_ctx->query_storage == NULL)
+    {
+        const size_t query_words    = (size_t)(matchfinder_ctx->max_block_size >> 6) + 1;
+        const size_t query_levels   = ESA_MF_QUERY_LEVELS_MAX;
+        const size_t num_intervals  = (size_t)matchfinder_ctx->max_block_size + (size_t)esa_matchfinder_hot_intervals_size(matchfinder_ctx->max_block_size);
+
+        uint8_t * query_storage     = (uint8_t *)esa_matchfinder_alloc_aligned(
+            query_levels * query_words * sizeof(uint64_t) +
+            query_levels * query_words * sizeof(uint32_t) +
+            2 * num_intervals * sizeof(uint32_t), ESA_MF_STORAGE_PADDING);
+
+        if (query_storage == NULL)
+        {
+            return ESA_MATCHFINDER_BAD_PARAMETER;
+        }
+
+        matchfinder_ctx->query_storage      = (void *)query_storage;
+        matchfinder_ctx->query_bitmap       = (uint64_t *)(void *)(query_storage);
+        matchfinder_ctx->query_ranks        = (uint32_t *)(void *)(query_storage + query_levels * query_words * sizeof(uint64_t));
+        matchfinder_ctx->query_intervals    = (uint32_t *)(void *)(query_storage + query_levels * query_words * (sizeof(uint64_t) + sizeof(uint32_t)));
+    }
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+void * esa_matchfinder_create(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length)
+{
+    if ((max_block_size     < 0) ||
+        (max_block_size     > ESA_MATCHFINDER_MAX_BLOCK_SIZE) ||
+        (min_match_length   < ESA_MATCHFINDER_MIN_MATCH_LENGTH) ||
+        (max_match_length   > (int32_t)ESA_MF_LCP_MAX + min_match_length - 1) ||
+        (max_match_length   < min_match_length))
+    {
+        return NULL;
+    }
+
+    return (void *)esa_matchfinder_alloc_ctx(max_block_size, min_match_length, max_match_length, 1, NULL, NULL);
+}
+
+#if defined(_OPENMP)
+
+void * esa_matchfinder_create_omp(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads)
+{
+    if ((max_block_size     < 0) ||
+        (max_block_size     > ESA_MATCHFINDER_MAX_BLOCK_SIZE) ||
+        (min_match_length   < ESA_MATCHFINDER_MIN_MATCH_LENGTH) ||
+        (max_match_length   > (int32_t)ESA_MF_LCP_MAX + min_match_length - 1) ||
+        (max_match_length   < min_match_length) ||
+        (num_threads        < 0))
+    {
+        return NULL;
+    }
+
+    num_threads = num_threads > 0 ? num_threads : omp_get_max_threads();
+    return (void *)esa_matchfinder_alloc_ctx(max_block_size, min_match_length, max_match_length, num_threads, NULL, NULL);
+}
+
+#endif
+
+void * esa_matchfinder_create_parallel(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads, esa_matchfinder_parallel_for parallel_for, void * context)
+{
+    if ((max_block_size     < 0) ||
+        (max_block_size     > ESA_MATCHFINDER_MAX_BLOCK_SIZE) ||
+        (min_match_length   < ESA_MATCHFINDER_MIN_MATCH_LENGTH) ||
+        (max_match_length   > (int32_t)ESA_MF_LCP_MAX + min_match_length - 1) ||
+        (max_match_length   < min_match_length) ||
+        (num_threads        < 0))
+    {
+        return NULL;
+    }
+
+    num_threads     = num_threads > 0 ? num_threads : esa_matchfinder_default_num_threads();
+    num_threads     = num_threads < ESA_MF_NUM_THREADS_MAX ? num_threads : ESA_MF_NUM_THREADS_MAX;
+
+    if (parallel_for != NULL)
+    {
+        return (void *)esa_matchfinder_alloc_ctx(max_block_size, min_match_length, max_match_length, num_threads, parallel_for, context);
+    }
+
+    ESA_MF_THREAD_POOL * pool = esa_matchfinder_create_thread_pool(num_threads);
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    ESA_MF_CONTEXT * matchfinder_ctx = esa_matchfinder_alloc_ctx(max_block_size, min_match_length, max_match_length, num_threads, esa_matchfinder_default_parallel_for, pool);
+    if (matchfinder_ctx == NULL)
+    {
+        esa_matchfinder_destroy_thread_pool(pool);
+        return NULL;
+    }
+
+    matchfinder_ctx->thread_pool = pool;
+
+    return (void *)matchfinder_ctx;
+}
+
+static int64_t esa_matchfinder_estimate_libsais_memory(int32_t num_threads)
+{
+    int64_t memory = (int64_t)ESA_MF_LIBSAIS_CTX_SIZE;
+
+    if (num_threads > 1)
+    {
+        memory += (int64_t)num_threads * (int64_t)ESA_MF_LIBSAIS_THREAD_SIZE + ESA_MF_LIBSAIS_THREADS_OVERHEAD;
+    }
+
+    return memory;
+}
+
+static int64_t esa_matchfinder_estimate_ctx_memory(int32_t max_block_size, int32_t num_threads)
+{
+    max_block_size                          = (max_block_size + ESA_MF_STORAGE_PADDING - 1) & (-ESA_MF_STORAGE_PADDING);
+
+    size_t              page_size           = esa_matchfinder_page_size();
+
+    int64_t             memory              = 0;
+
+    memory += (int64_t)sizeof(ESA_MF_CONTEXT) + ESA_MF_STORAGE_PADDING;
+    memory += (int64_t)((esa_matchfinder_storage_size(max_block_size) + page_size - 1) & (~(page_size - 1)));
+
+#if defined(_OPENMP)
+    memory += esa_matchfinder_estimate_libsais_memory(num_threads);
+
+    if (num_threads > 2)
+    {
+        memory += esa_matchfinder_estimate_libsais_memory(num_threads - 1);
+    }
+#else
+    memory += esa_matchfinder_estimate_libsais_memory(1);
+
+    if (num_threads > 1)
+    {
+        memory += (int64_t)sizeof(ESA_MF_THREAD_POOL) + ESA_MF_STORAGE_PADDING;
+    }
+#endif
+
+    if (num_threads > 1)
+    {
+        memory += (int64_t)num_threads * (int64_t)sizeof(ESA_MF_BUILD_PROFILE) + ESA_MF_STORAGE_PADDING;
+    }
+
+    return memory;
+}
+
+int64_t esa_matchfinder_estimate_memory(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads)
+{
+    if ((max_block_size     < 0) ||
+        (max_block_size     > ESA_MATCHFINDER_MAX_BLOCK_SIZE) ||
+        (min_match_length   < ESA_MATCHFINDER_MIN_MATCH_LENGTH) ||
+        (max_match_length   > (int32_t)ESA_MF_LCP_MAX + min_match_length - 1) ||
+        (max_match_length   < min_match_length) ||
+        (num_threads        < 0))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+#if defined(_OPENMP)
+    num_threads = num_threads > 0 ? num_threads : omp_get_max_threads();
+#else
+    num_threads = num_threads > 0 ? num_threads : esa_matchfinder_default_num_threads();
+#endif
+    num_threads = num_threads < ESA_MF_NUM_THREADS_MAX ? num_threads : ESA_MF_NUM_THREADS_MAX;
+
+    return esa_matchfinder_estimate_ctx_memory(max_block_size, num_threads);
+}
+
+void * esa_matchfinder_create_with_budget(int64_t memory_budget, int32_t min_match_length, int32_t max_match_length, int32_t num_threads)
+{
+    int64_t minimum_memory = esa_matchfinder_estimate_memory(0, min_match_length, max_match_length, num_threads);
+
+    if ((minimum_memory < 0) || (minimum_memory > memory_budget))
+    {
+        return NULL;
+    }
+
+    int32_t low = 0, high = ESA_MATCHFINDER_MAX_BLOCK_SIZE / ESA_MF_STORAGE_PADDING;
+    while (low < high)
+    {
+        int32_t middle = low + (high - low + 1) / 2;
+
+        if (esa_matchfinder_estimate_memory(middle * ESA_MF_STORAGE_PADDING, min_match_length, max_match_length, num_threads) <= memory_budget)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    int32_t max_block_size = low * ESA_MF_STORAGE_PADDING;
+
+    if (num_threads == 1)
+    {
+        return esa_matchfinder_create(max_block_size, min_match_length, max_match_length);
+    }
+
+#if defined(_OPENMP)
+    return esa_matchfinder_create_omp(max_block_size, min_match_length, max_match_length, num_threads);
+#else
+    return esa_matchfinder_create_parallel(max_block_size, min_match_length, max_match_length, num_threads, NULL, NULL);
+#endif
+}
+
+int32_t esa_matchfinder_get_max_block_size(const void * mf)
+{
+    const ESA_MF_CONTEXT * matchfinder_ctx = (const ESA_MF_CONTEXT *)mf;
+
+    return matchfinder_ctx != NULL ? matchfinder_ctx->max_block_size : ESA_MATCHFINDER_BAD_PARAMETER;
+}
+
+typedef struct ESA_MF_PLACE_TASK
+{
+    uint64_t *              sa_parent_link;
+    uint32_t *              plcp_leaf_link;
+    ptrdiff_t               n;
+} ESA_MF_PLACE_TASK;
+
+static void esa_matchfinder_numa_first_touch_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_PLACE_TASK * place_task = (ESA_MF_PLACE_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (place_task->n / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+    ptrdiff_t omp_block_size      = task < num_tasks - 1 ? omp_block_stride : place_task->n - omp_block_start;
+
+    memset(place_task->sa_parent_link + omp_block_start, 0, (size_t)omp_block_size * sizeof(uint64_t));
+    memset(place_task->plcp_leaf_link + omp_block_start, 0, (size_t)omp_block_size * sizeof(uint32_t));
+}
+
+int32_t esa_matchfinder_numa_first_touch(void * mf)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if (matchfinder_ctx == NULL)
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    matchfinder_ctx->fixed_layout = 1;
+    esa_matchfinder_set_block_layout(matchfinder_ctx, esa_matchfinder_layout_block_size(matchfinder_ctx, matchfinder_ctx->max_block_size));
+
+    ESA_MF_PLACE_TASK place_task = { matchfinder_ctx->sa_parent_link, matchfinder_ctx->plcp_leaf_link, matchfinder_ctx->max_block_size };
+    esa_matchfinder_run_tasks(matchfinder_ctx, matchfinder_ctx->num_threads, esa_matchfinder_numa_first_touch_task, &place_task);
+
+    matchfinder_ctx->query_levels   = 0;
+    matchfinder_ctx->block          = NULL;
+    matchfinder_ctx->block_size     = -1;
+
+    esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)-1);
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+static void esa_matchfinder_free_block_storage(ESA_MF_CONTEXT * matchfinder_ctx)
+{
+    esa_matchfinder_free_aligned(matchfinder_ctx->delta_block);
+    esa_matchfinder_free_aligned(matchfinder_ctx->cursor_parent_link);
+    esa_matchfinder_free_aligned(matchfinder_ctx->query_storage);
+
+    matchfinder_ctx->delta_block        = NULL;
+    matchfinder_ctx->cursor_parent_link = NULL;
+    matchfinder_ctx->query_intervals    = NULL;
+    matchfinder_ctx->query_ranks        = NULL;
+    matchfinder_ctx->query_bitmap       = NULL;
+    matchfinder_ctx->query_storage      = NULL;
+    matchfinder_ctx->query_words        = 0;
+    matchfinder_ctx->query_levels       = 0;
+
+    matchfinder_ctx->block              = NULL;
+    matchfinder_ctx->block_size         = -1;
+
+    esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)-1);
+}
+
+int32_t esa_matchfinder_shrink(void * mf, int32_t max_block_size)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if ((matchfinder_ctx == NULL) || (max_block_size < 0) || (max_block_size > matchfinder_ctx->max_block_size))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    max_block_size = (max_block_size + ESA_MF_STORAGE_PADDING - 1) & (-ESA_MF_STORAGE_PADDING);
+
+    if (max_block_size < matchfinder_ctx->max_block_size)
+    {
+        esa_matchfinder_trim_pages(matchfinder_ctx->esa_storage, esa_matchfinder_storage_size(matchfinder_ctx->max_block_size), esa_matchfinder_storage_size(max_block_size));
+        esa_matchfinder_attach_storage(matchfinder_ctx, matchfinder_ctx->esa_storage, max_block_size);
+    }
+
+    matchfinder_ctx->fixed_layout = 0;
+    esa_matchfinder_free_block_storage(matchfinder_ctx);
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+int32_t esa_matchfinder_release_memory(void * mf)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if (matchfinder_ctx == NULL)
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    matchfinder_ctx->fixed_layout = 0;
+    esa_matchfinder_free_block_storage(matchfinder_ctx);
+    esa_matchfinder_release_pages(matchfinder_ctx->esa_storage, esa_matchfinder_storage_size(matchfinder_ctx->max_block_size));
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+void esa_matchfinder_destroy(void * mf)
+{
+    esa_matchfinder_free_ctx((ESA_MF_CONTEXT *)mf);
+}
+
+static uint64_t esa_matchfinder_sort_key(const uint8_t * ESA_MF_RESTRICT T, uint64_t p, uint64_t n, uint64_t depth, uint64_t max_depth)
+{
+    uint64_t length     = max_depth - depth < 7 ? max_depth - depth : 7;
+    uint64_t available  = p + depth < n ? n - p - depth : 0;
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__) && (defined(__GNUC__) || defined(__clang__))
+    if (available >= 8)
+    {
+        uint64_t x; memcpy(&x, &T[p + depth], sizeof(uint64_t));
+        return (__builtin_bswap64(x) & ((~(uint64_t)0) << (64 - 8 * length))) + length + 1;
+    }
+#endif
+
+    uint64_t key = available > length ? length + 1 : available;
+    for (uint64_t k = 0, m = available < length ? available : length; k < m; k += 1) { key += (uint64_t)T[p + depth + k] << (56 - 8 * k); }
+
+    return key;
+}
+
+static void esa_matchfinder_sort_suffixes(const uint8_t * ESA_MF_RESTRICT T, uint32_t * ESA_MF_RESTRICT SA, uint32_t * ESA_MF_RESTRICT buffer, uint64_t n, ptrdiff_t count, uint64_t depth, uint64_t max_depth)
+{
+    while (count > ESA_MF_SORT_INSERTION_THRESHOLD)
+    {
+        if (depth >= max_depth)
+        {
+            return;
+        }
+
+        uint64_t a = esa_matchfinder_sort_key(T, SA[0], n, depth, max_depth);
+        uint64_t b = esa_matchfinder_sort_key(T, SA[count >> 1], n, depth, max_depth);
+        uint64_t c = esa_matchfinder_sort_key(T, SA[count - 1], n, depth, max_depth);
+        uint64_t pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        ptrdiff_t lt = 0, eq = 0, gt = count;
+        for (ptrdiff_t i = 0; i < count; i += 1)
+        {
+            uint32_t p      = SA[i];
+            uint64_t key    = esa_matchfinder_sort_key(T, p, n, depth, max_depth);
+
+            SA[lt] = p; buffer[eq] = p; buffer[gt - 1] = p;
+
+            lt += key < pivot;
+            gt -= key > pivot;
+            eq += key == pivot;
+        }
+
+        memcpy(SA + lt, buffer, (size_t)eq * sizeof(uint32_t));
+        for (ptrdiff_t i = count - 1, j = gt; i >= gt; i -= 1, j += 1) { SA[j] = buffer[i]; }
+
+        if ((pivot & 0xff) == 8)
+        {
+            esa_matchfinder_sort_suffixes(T, SA + lt, buffer + lt, n, gt - lt, depth + 7, max_depth);
+        }
+
+        if (lt < count - gt)    { esa_matchfinder_sort_suffixes(T, SA, buffer, n, lt, depth, max_depth); SA += gt; buffer += gt; count -= gt; }
+        else                    { esa_matchfinder_sort_suffixes(T, SA + gt, buffer + gt, n, count - gt, depth, max_depth); count = lt; }
+    }
+
+    if (depth >= max_depth)
+    {
+        return;
+    }
+
+    uint64_t keys[ESA_MF_SORT_INSERTION_THRESHOLD];
+
+    for (ptrdiff_t i = 0; i < count; i += 1)
+    {
+        uint64_t key = esa_matchfinder_sort_key(T, SA[i], n, depth, max_depth);
+        uint32_t p = SA[i]; ptrdiff_t j = i - 1;
+
+        while (j >= 0 && keys[j] > key) { keys[j + 1] = keys[j]; SA[j + 1] = SA[j]; j -= 1; }
+        keys[j + 1] = key; SA[j + 1] = p;
+    }
+
+    for (ptrdiff_t i = 0, j; i < count; i = j)
+    {
+        for (j = i + 1; j < count && keys[j] == keys[i]; j += 1) { }
+
+        if (j - i > 1 && (keys[i] & 0xff) == 8)
+        {
+            esa_matchfinder_sort_suffixes(T, SA + i, buffer + i, n, j - i, depth + 7, max_depth);
+        }
+    }
+}
+
+typedef struct ESA_MF_SORT_TASK
+{
+    const uint8_t *         T;
+    uint32_t *              SA;
+    const uint32_t *        buckets;
+    uint64_t                n;
+    uint64_t                max_depth;
+} ESA_MF_SORT_TASK;
+
+static void esa_matchfinder_sort_buckets_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_SORT_TASK * sort_task = (ESA_MF_SORT_TASK *)task_context;
+
+    uint64_t omp_block_start    = (sort_task->n * (uint64_t)(task + 0)) / (uint64_t)num_tasks;
+    uint64_t omp_block_end      = (sort_task->n * (uint64_t)(task + 1)) / (uint64_t)num_tasks;
+
+    for (ptrdiff_t bucket = 0; bucket < ESA_MF_SORT_BUCKETS; bucket += 1)
+    {
+        uint64_t bucket_start = sort_task->buckets[bucket], bucket_end = sort_task->buckets[bucket + 1];
+
+        if (bucket_start >= omp_block_start && bucket_start < omp_block_end && bucket_end - bucket_start > 1)
+        {
+            esa_matchfinder_sort_suffixes(sort_task->T, sort_task->SA + bucket_start, sort_task->SA + sort_task->n + bucket_start, sort_task->n, (ptrdiff_t)(bucket_end - bucket_start), 2, sort_task->max_depth);
+        }
+    }
+}
+
+static int32_t esa_matchfinder_sort_suffixes_bounded_omp(const ESA_MF_CONTEXT * matchfinder_ctx, const uint8_t * T, uint32_t * SA, ptrdiff_t n, ptrdiff_t num_threads)
+{
+    uint32_t * buckets = (uint32_t *)esa_matchfinder_alloc_aligned((ESA_MF_SORT_BUCKETS + 1) * sizeof(uint32_t), ESA_MF_STORAGE_PADDING);
+    if (buckets == NULL)
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    memset(buckets, 0, (ESA_MF_SORT_BUCKETS + 1) * sizeof(uint32_t));
+
+    for (ptrdiff_t i = 0; i < n; i += 1)
+    {
+        buckets[(T[i] + 1) * 257 + (i + 1 < n ? T[i + 1] + 1 : 0) + 1] += 1;
+    }
+
+    for (ptrdiff_t bucket = 0; bucket < ESA_MF_SORT_BUCKETS; bucket += 1)
+    {
+        buckets[bucket + 1] += buckets[bucket];
+    }
+
+    for (ptrdiff_t i = 0; i < n; i += 1)
+    {
+        SA[buckets[(T[i] + 1) * 257 + (i + 1 < n ? T[i + 1] + 1 : 0)]++] = (uint32_t)i;
+    }
+
+    memmove(buckets + 1, buckets, ESA_MF_SORT_BUCKETS * sizeof(uint32_t)); buckets[0] = 0;
+
+    if (matchfinder_ctx->max_match_length > 2)
+    {
+        ESA_MF_SORT_TASK sort_task = { T, SA, buckets, (uint64_t)n, (uint64_t)matchfinder_ctx->max_match_length };
+        esa_matchfinder_run_tasks(matchfinder_ctx, esa_matchfinder_num_tasks(num_threads, n, ESA_MF_SORT_GRAIN_SIZE), esa_matchfinder_sort_buckets_task, &sort_task);
+    }
+
+    esa_matchfinder_free_aligned(buckets);
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+static int32_t esa_matchfinder_sort_suffixes_tiny(const ESA_MF_CONTEXT * matchfinder_ctx, const uint8_t * T, uint32_t * SA, ptrdiff_t n)
+{
+    for (ptrdiff_t i = 0; i < n; i += 1) { SA[i] = (uint32_t)i; }
+
+    esa_matchfinder_sort_suffixes(T, SA, SA + n, (uint64_t)n, n, 0, (uint64_t)matchfinder_ctx->max_match_length);
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+static void esa_matchfinder_copy_cursor_parent_link(ESA_MF_CONTEXT * matchfinder_ctx)
+{
+    const uint64_t * ESA_MF_RESTRICT const  sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint64_t * ESA_MF_RESTRICT const        cursor_parent_link  = matchfinder_ctx->cursor_parent_link;
+
+    for (ptrdiff_t i = 0, n = (ptrdiff_t)matchfinder_ctx->block_size + matchfinder_ctx->hot_intervals_size; i < n; i += 1)
+    {
+        cursor_parent_link[i] = sa_parent_link[i] & (~ESA_MF_OFFSET_MASK);
+    }
+}
+
+static int32_t esa_matchfinder_parse_block(ESA_MF_CONTEXT * matchfinder_ctx, const uint8_t * block, int32_t block_size, int32_t query_index, int32_t num_threads, uint32_t * suffix_array)
+{
+    if ((matchfinder_ctx == NULL) || (block == NULL) || (block_size < 0) || (block_size > matchfinder_ctx->max_block_size) || (num_threads < 0))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    num_threads = num_threads > 0 && num_threads < matchfinder_ctx->num_threads ? num_threads : matchfinder_ctx->num_threads;
+
+    if (query_index && esa_matchfinder_alloc_query_index(matchfinder_ctx) != ESA_MATCHFINDER_NO_ERROR)
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    matchfinder_ctx->query_levels = 0;
+    matchfinder_ctx->block = block;
+    matchfinder_ctx->block_size = block_size;
+    matchfinder_ctx->parse_num_threads = num_threads;
+
+    esa_matchfinder_set_block_layout(matchfinder_ctx, esa_matchfinder_layout_block_size(matchfinder_ctx, block_size));
+    memset(matchfinder_ctx->esa_storage, 0, ESA_MF_STORAGE_PADDING * sizeof(int32_t));
+    memset(matchfinder_ctx->plcp_leaf_link + matchfinder_ctx->block_size, 0, ESA_MF_STORAGE_PADDING * sizeof(int32_t));
+
+    int32_t result = ESA_MATCHFINDER_BAD_PARAMETER;
+
+    if (matchfinder_ctx->block_size <= ESA_MF_SORT_TINY_BLOCK_SIZE)
+    {
+        result = esa_matchfinder_sort_suffixes_tiny(
+            matchfinder_ctx,
+            block,
+            (uint32_t *)(void *)matchfinder_ctx->sa_parent_link,
+            matchfinder_ctx->block_size);
+    }
+    else if (matchfinder_ctx->sort_mode == ESA_MATCHFINDER_SORT_BOUNDED)
+    {
+        result = esa_matchfinder_sort_suffixes_bounded_omp(
+            matchfinder_ctx,
+            block,
+            (uint32_t *)(void *)matchfinder_ctx->sa_parent_link,
+            matchfinder_ctx->block_size,
+            num_threads);
+    }
+
+    if (result != ESA_MATCHFINDER_NO_ERROR)
+    {
+#if defined(_OPENMP)
+        result = num_threads < matchfinder_ctx->num_threads && matchfinder_ctx->parallel_for == NULL
+            ? libsais_omp(
+                block,
+                (int32_t *)(void *)matchfinder_ctx->sa_parent_link,
+                matchfinder_ctx->block_size,
+                matchfinder_ctx->block_size + 2 * matchfinder_ctx->hot_intervals_size,
+                NULL,
+                num_threads)
+            : libsais_ctx(
+                matchfinder_ctx->libsais_ctx,
+                block,
+                (int32_t *)(void *)matchfinder_ctx->sa_parent_link,
+                matchfinder_ctx->block_size,
+                matchfinder_ctx->block_size + 2 * matchfinder_ctx->hot_intervals_size,
+                NULL);
+#else
+        result = libsais_ctx(
+            matchfinder_ctx->libsais_ctx,
+            block,
+            (int32_t *)(void *)matchfinder_ctx->sa_parent_link,
+            matchfinder_ctx->block_size,
+            matchfinder_ctx->block_size + 2 * matchfinder_ctx->hot_intervals_size,
+            NULL);
+#endif
+    }
+
+    uint32_t * SA = NULL;
+
+    if (result == ESA_MATCHFINDER_NO_ERROR && suffix_array != NULL)
+    {
+        memcpy(suffix_array, matchfinder_ctx->sa_parent_link, (size_t)matchfinder_ctx->block_size * sizeof(uint32_t));
+    }
+
+    if (result == ESA_MATCHFINDER_NO_ERROR && query_index)
+    {
+        SA = (uint32_t *)esa_matchfinder_alloc_aligned(2 * ((size_t)matchfinder_ctx->block_size + 1) * sizeof(uint32_t), ESA_MF_STORAGE_PADDING);
+
+        if (SA != NULL)
+        {
+            memcpy(SA, matchfinder_ctx->sa_parent_link, (size_t)matchfinder_ctx->block_size * sizeof(uint32_t));
+        }
+        else
+        {
+            result = ESA_MATCHFINDER_BAD_PARAMETER;
+        }
+    }
+
+    if (result == ESA_MATCHFINDER_NO_ERROR)
+    {
+        esa_matchfinder_build_interval_tree_omp(
+            matchfinder_ctx,
+            block,
+            matchfinder_ctx->sa_parent_link,
+            matchfinder_ctx->plcp_leaf_link,
+            (uint64_t)matchfinder_ctx->min_match_length,
+            (uint64_t)matchfinder_ctx->max_match_length,
+            matchfinder_ctx->block_size,
+            num_threads,
+            matchfinder_ctx->threads);
+
+        if (SA != NULL)
+        {
+            esa_matchfinder_build_query_intervals(
+                matchfinder_ctx->sa_parent_link,
+                matchfinder_ctx->plcp_leaf_link,
+                SA,
+                matchfinder_ctx->query_intervals,
+                matchfinder_ctx->block_size,
+                (ptrdiff_t)matchfinder_ctx->block_size + matchfinder_ctx->hot_intervals_size);
+
+            esa_matchfinder_build_query_wavelet_matrix(
+                matchfinder_ctx,
+                SA,
+                SA + matchfinder_ctx->block_size + 1,
+                matchfinder_ctx->block_size);
+        }
+
+        if (matchfinder_ctx->cursor_parent_link != NULL)
+        {
+            esa_matchfinder_copy_cursor_parent_link(matchfinder_ctx);
+        }
+
+        esa_matchfinder_set_position(matchfinder_ctx, 0);
+    }
+
+    esa_matchfinder_free_aligned(SA);
+
+    return result;
+}
+
+int32_t esa_matchfinder_set_sort_mode(void * mf, int32_t sort_mode)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if ((matchfinder_ctx == NULL) || (sort_mode != ESA_MATCHFINDER_SORT_FULL && sort_mode != ESA_MATCHFINDER_SORT_BOUNDED))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    matchfinder_ctx->sort_mode = sort_mode;
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+int32_t esa_matchfinder_get_isa(const void * mf)
+{
+    const ESA_MF_CONTEXT * matchfinder_ctx = (const ESA_MF_CONTEXT *)mf;
+
+    return matchfinder_ctx != NULL ? matchfinder_ctx->isa : ESA_MATCHFINDER_BAD_PARAMETER;
+}
+
+int32_t esa_matchfinder_parse(void * mf, const uint8_t * block, int32_t block_size)
+{
+    return esa_matchfinder_parse_block((ESA_MF_CONTEXT *)mf, block, block_size, 0, 0, NULL);
+}
+
+int32_t esa_matchfinder_parse_ex(void * mf, const uint8_t * block, int32_t block_size, int32_t num_threads)
+{
+    return esa_matchfinder_parse_block((ESA_MF_CONTEXT *)mf, block, block_size, 0, num_threads, NULL);
+}
+
+int32_t esa_matchfinder_parse_with_query_index(void * mf, const uint8_t * block, int32_t block_size)
+{
+    return esa_matchfinder_parse_block((ESA_MF_CONTEXT *)mf, block, block_size, 1, 0, NULL);
+}
+
+typedef struct ESA_MF_BATCH_TASK
+{
+    void **                 mfs;
+    const uint8_t **        blocks;
+    const int32_t *         block_sizes;
+    ptrdiff_t               count;
+    int32_t                 results[ESA_MF_NUM_THREADS_MAX];
+} ESA_MF_BATCH_TASK;
+
+static void esa_matchfinder_parse_batch_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_BATCH_TASK * batch_task = (ESA_MF_BATCH_TASK *)task_context;
+
+    batch_task->results[task] = ESA_MATCHFINDER_NO_ERROR;
+
+    for (ptrdiff_t index = task; index < batch_task->count; index += num_tasks)
+    {
+        ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)batch_task->mfs[index];
+
+        if (esa_matchfinder_parse_block(matchfinder_ctx, batch_task->blocks[index], batch_task->block_sizes[index], 0, 1, NULL) != ESA_MATCHFINDER_NO_ERROR)
+        {
+            batch_task->results[task] = ESA_MATCHFINDER_BAD_PARAMETER;
+        }
+        else
+        {
+            matchfinder_ctx->parse_num_threads = matchfinder_ctx->num_threads;
+        }
+    }
+}
+
+int32_t esa_matchfinder_parse_batch(void ** mfs, const uint8_t ** blocks, const int32_t * block_sizes, int32_t count)
+{
+    if ((mfs == NULL) || (blocks == NULL) || (block_sizes == NULL) || (count < 0))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    int32_t result = ESA_MATCHFINDER_NO_ERROR;
+
+    ESA_MF_CONTEXT * matchfinder_ctx = count > 1 ? (ESA_MF_CONTEXT *)mfs[0] : NULL;
+
+    if (matchfinder_ctx != NULL && matchfinder_ctx->parallel_for != NULL && matchfinder_ctx->num_threads > 1)
+    {
+        ESA_MF_BATCH_TASK batch_task = { mfs, blocks, block_sizes, count, { 0 } };
+
+        ptrdiff_t num_tasks = count < matchfinder_ctx->num_threads ? count : matchfinder_ctx->num_threads;
+        esa_matchfinder_run_tasks(matchfinder_ctx, num_tasks, esa_matchfinder_parse_batch_task, &batch_task);
+
+        for (ptrdiff_t task = 0; task < num_tasks; task += 1)
+        {
+            if (batch_task.results[task] != ESA_MATCHFINDER_NO_ERROR)
+            {
+                result = ESA_MATCHFINDER_BAD_PARAMETER;
+            }
+        }
+
+        return result;
+    }
+
+    for (ptrdiff_t index = 0; index < count; index += 1)
+    {
+        if (esa_matchfinder_parse(mfs[index], blocks[index], block_sizes[index]) != ESA_MATCHFINDER_NO_ERROR)
+        {
+            result = ESA_MATCHFINDER_BAD_PARAMETER;
+        }
+    }
+
+    return result;
+}
+
+#if defined(_OPENMP)
+
+int32_t esa_matchfinder_parse_batch_omp(void ** mfs, const uint8_t ** blocks, const int32_t * block_sizes, int32_t count, int32_t num_threads)
+{
+    if ((mfs == NULL) || (blocks == NULL) || (block_sizes == NULL) || (count < 0) || (num_threads < 0))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    int32_t result = ESA_MATCHFINDER_NO_ERROR;
+
+    num_threads = num_threads > 0 ? num_threads : omp_get_max_threads();
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) if(num_threads > 1 && count > 1)
+    for (ptrdiff_t index = 0; index < count; index += 1)
+    {
+        if (esa_matchfinder_parse(mfs[index], blocks[index], block_sizes[index]) != ESA_MATCHFINDER_NO_ERROR)
+        {
+            #pragma omp atomic write
+            result = ESA_MATCHFINDER_BAD_PARAMETER;
+        }
+    }
+
+    return result;
+}
+
+#endif
+
+int32_t esa_matchfinder_parse_delta(void * mf, const uint8_t * source, int32_t source_size, const uint8_t * target, int32_t target_size)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if ((matchfinder_ctx == NULL) || (source == NULL && source_size > 0) || (target == NULL && target_size > 0) || (source_size < 0) || (target_size < 0) ||
+        ((int64_t)source_size + (int64_t)target_size > (int64_t)matchfinder_ctx->max_block_size))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    if (matchfinder_ctx->delta_block == NULL)
+    {
+        matchfinder_ctx->delta_block = (uint8_t *)esa_matchfinder_alloc_aligned((size_t)matchfinder_ctx->max_block_size + 1, ESA_MF_STORAGE_PADDING);
+
+        if (matchfinder_ctx->delta_block == NULL)
+        {
+            return ESA_MATCHFINDER_BAD_PARAMETER;
+        }
+    }
+
+    if (source_size > 0) { memcpy(matchfinder_ctx->delta_block, source, (size_t)source_size); }
+    if (target_size > 0) { memcpy(matchfinder_ctx->delta_block + source_size, target, (size_t)target_size); }
+
+    int32_t result = esa_matchfinder_parse(mf, matchfinder_ctx->delta_block, source_size + target_size);
+
+    if (result == ESA_MATCHFINDER_NO_ERROR && source_size > 0)
+    {
+        esa_matchfinder_fast_forward(matchfinder_ctx->sa_parent_link, matchfinder_ctx->plcp_leaf_link, (uint64_t)source_size);
+        esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)source_size);
+    }
+
+    return result;
+}
+
+int32_t esa_matchfinder_get_position(void * mf)
+{
+    return (int32_t)((ESA_MF_CONTEXT *)mf)->position;
+}
+
+int32_t esa_matchfinder_rewind(void * mf, int32_t position)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if ((matchfinder_ctx == NULL) || (position < 0) || (position >= matchfinder_ctx->block_size))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    if (matchfinder_ctx->position != (uint64_t)position)
+    {
+        if (matchfinder_ctx->position != 0)
+        {
+            for (ptrdiff_t thread = 0; thread < matchfinder_ctx->num_threads; thread += 1)
+            {
+                ptrdiff_t interval_tree_start   = matchfinder_ctx->threads[thread].interval_tree_start;
+                ptrdiff_t interval_tree_end     = matchfinder_ctx->threads[thread].interval_tree_end;
+
+                if (interval_tree_start < interval_tree_end)
+                {
+                    esa_matchfinder_reset_interval_tree_omp(
+                        matchfinder_ctx,
+                        matchfinder_ctx->sa_parent_link + interval_tree_start,
+                        interval_tree_end - interval_tree_start,
+                        matchfinder_ctx->parse_num_threads);
+                }
+
+                ptrdiff_t hot_interval_tree_start   = matchfinder_ctx->threads[thread].hot_interval_tree_start;
+                ptrdiff_t hot_interval_tree_end     = matchfinder_ctx->threads[thread].hot_interval_tree_end;
+
+                if (hot_interval_tree_start < hot_interval_tree_end)
+                {
+                    esa_matchfinder_reset_interval_tree(
+                        matchfinder_ctx->sa_parent_link,
+                        hot_interval_tree_start,
+                        hot_interval_tree_end - hot_interval_tree_start,
+                        matchfinder_ctx->isa);
+                }
+            }
+        }
+
+        if (position > 0)
+        {
+            esa_matchfinder_fast_forward(matchfinder_ctx->sa_parent_link, matchfinder_ctx->plcp_leaf_link, (uint64_t)position);
+        }
+
+        esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)position);
+    }
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+ESA_MATCHFINDER_MATCH * esa_matchfinder_find_all_matches(void * mf, ESA_MATCHFINDER_MATCH * matches)
+{
+    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+
+    const ptrdiff_t                                 prefetch_distance   = 4;
+    const uint64_t                                  position            = matchfinder_ctx->position++;
+
+    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT         next_match          = matches;
+
+    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+
+    if (matchfinder_ctx->deferred_count != 0)
+    {
+        esa_matchfinder_apply_deferred_updates(matchfinder_ctx);
+    }
+
+    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
+    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+    uint64_t best_match             = (uint64_t)(uint32_t)-1;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = sa_parent_link[reference];
+        const uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)next_match = match;
+        }
+        else
+#endif
+        {
+            next_match->length      = (int32_t)(match      );
+            next_match->offset      = (int32_t)(match >> 32);
+        }
+
+        next_match                 += match > best_match;
+        best_match                  = match;
+
+        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    return next_match;
+}
+
+ESA_MATCHFINDER_MATCH * esa_matchfinder_find_all_matches_in_window(void * mf, ESA_MATCHFINDER_MATCH * matches, uint64_t window_size)
+{
+    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+
+    const ptrdiff_t                                 prefetch_distance   = 4;
+    const uint64_t                                  position            = matchfinder_ctx->position++;
+
+    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT         next_match          = matches;
+
+    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+
+    if (matchfinder_ctx->deferred_count != 0)
+    {
+        esa_matchfinder_apply_deferred_updates(matchfinder_ctx);
+    }
+
+    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
+    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+    uint64_t best_match             = (position > window_size ? (position - window_size) << 32 : 0) + (uint64_t)(uint32_t)-1;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = sa_parent_link[reference];
+        const uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)next_match = match;
+        }
+        else
+#endif
+        {
+            next_match->length      = (int32_t)(match      );
+            next_match->offset      = (int32_t)(match >> 32);
+        }
+
+        next_match                 += match > best_match;
+        best_match                  = match;
+
+        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    return next_match;
+}
+
+ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match(void * mf)
+{
+    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+
+    const ptrdiff_t                                 prefetch_distance   = 4;
+    const uint64_t                                  position            = matchfinder_ctx->position++;
+
+    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+
+    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+
+    if (matchfinder_ctx->deferred_count != 0)
+    {
+        esa_matchfinder_apply_deferred_updates(matchfinder_ctx);
+    }
+
+    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
+    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+    uint64_t best_match             = 0;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = sa_parent_link[reference];
+              uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+
+        match                       = interval & ESA_MF_OFFSET_MASK ? match : best_match;
+        best_match                  = best_match == 0               ? match : best_match;
+
+        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    {
+        ESA_MATCHFINDER_MATCH match;
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)&match = best_match;
+        }
+        else
+#endif
+        {
+            match.length            = (int32_t)(best_match      );
+            match.offset            = (int32_t)(best_match >> 32);
+        }
+
+        return match;
+    }
+}
+
+ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match_in_window(void * mf, uint64_t window_size)
+{
+    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+
+    const ptrdiff_t                                 prefetch_distance   = 4;
+    const uint64_t                                  position            = matchfinder_ctx->position++;
+
+    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+
+    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+
+    if (matchfinder_ctx->deferred_count != 0)
+    {
+        esa_matchfinder_apply_deferred_updates(matchfinder_ctx);
+    }
+
+    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
+    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+    const uint64_t match_cutoff     = (position > window_size ? (position - window_size) << 32 : 0) + (uint64_t)(uint32_t)-1;
+
+    uint64_t best_match             = 0;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = sa_parent_link[reference];
+              uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+
+        match                       = match > match_cutoff          ? match : best_match;
+        best_match                  = best_match == 0               ? match : best_match;
+
+        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    {
+        ESA_MATCHFINDER_MATCH match;
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)&match = best_match;
+        }
+        else
+#endif
+        {
+            match.length            = (int32_t)(best_match      );
+            match.offset            = (int32_t)(best_match >> 32);
+        }
+
+        return match;
+    }
+}
+
+ESA_MATCHFINDER_MATCH esa_matchfinder_find_nice_match(void * mf, int32_t nice_match_length)
+{
+    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+
+    const ptrdiff_t                                 prefetch_distance   = 4;
+    const uint64_t                                  position            = matchfinder_ctx->position++;
+
+    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+
+    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
     esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
     esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
     esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
@@ -819,218 +2904,1330 @@ ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match(void * mf)
     esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
     esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
 
-    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
-    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-    uint64_t best_match             = 0;
-    uint64_t reference              = plcp_leaf_link[position];
+    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
+    const uint64_t nice_match_lcp   = (uint64_t)nice_match_length > min_match_length ? (uint64_t)nice_match_length - min_match_length : 0;
+    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+    uint64_t best_match             = 0;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    if (nice_match_lcp < matchfinder_ctx->deferred_lcp)
+    {
+        esa_matchfinder_apply_deferred_updates(matchfinder_ctx);
+    }
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = sa_parent_link[reference];
+              uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+
+        if ((interval >> ESA_MF_LCP_SHIFT) < nice_match_lcp)
+        {
+            break;
+        }
+
+        match                       = interval & ESA_MF_OFFSET_MASK ? match : best_match;
+        best_match                  = best_match == 0               ? match : best_match;
+
+        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    if (reference != 0)
+    {
+        if (best_match != 0)
+        {
+            if (matchfinder_ctx->deferred_count == ESA_MF_DEFERRED_UPDATES_MAX)
+            {
+                esa_matchfinder_apply_deferred_updates(matchfinder_ctx);
+            }
+
+            matchfinder_ctx->deferred_updates[matchfinder_ctx->deferred_count++] = (position << 32) + reference;
+            matchfinder_ctx->deferred_lcp = nice_match_lcp > matchfinder_ctx->deferred_lcp ? nice_match_lcp : matchfinder_ctx->deferred_lcp;
+        }
+        else
+        {
+            if (matchfinder_ctx->deferred_count != 0)
+            {
+                esa_matchfinder_apply_deferred_updates(matchfinder_ctx);
+            }
+
+            while (reference != 0)
+            {
+                const uint64_t interval     = sa_parent_link[reference];
+                      uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+
+                match                       = interval & ESA_MF_OFFSET_MASK ? match : best_match;
+                best_match                  = best_match == 0               ? match : best_match;
+
+                sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+                reference                   = interval & ESA_MF_PARENT_MASK;
+            }
+        }
+    }
+
+    {
+        ESA_MATCHFINDER_MATCH match;
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)&match = best_match;
+        }
+        else
+#endif
+        {
+            match.length            = (int32_t)(best_match      );
+            match.offset            = (int32_t)(best_match >> 32);
+        }
+
+        return match;
+    }
+}
+
+static void esa_matchfinder_advance_backwards(void * mf, int32_t count)
+{
+    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+
+    const ptrdiff_t                                 prefetch_distance   = 4;
+    const uint64_t                                  current_position    = matchfinder_ctx->position;
+    const uint64_t                                  target_position     = matchfinder_ctx->position += (uint64_t)count;
+
+    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+
+    memset(matchfinder_ctx->prefetch, 0, sizeof(matchfinder_ctx->prefetch));
+
+    for (uint64_t position = target_position + prefetch_distance * 8; position-- != target_position; )
+    {
+        uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+
+        esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position - 8 * prefetch_distance])]);
+        esa_matchfinder_prefetchr(&plcp_leaf_link[position - 9 * prefetch_distance]);
+    }
+
+    for (uint64_t position = target_position; position-- != current_position; )
+    {
+        if (position >= 8 * prefetch_distance)
+        {
+            uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+
+            esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position - 8 * prefetch_distance])]);
+            esa_matchfinder_prefetchr(&plcp_leaf_link[position - 9 * prefetch_distance]);
+        }
+
+        const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+        uint64_t reference              = plcp_leaf_link[position];
+        uint64_t interval               = sa_parent_link[reference];
+
+        while ((interval & ESA_MF_OFFSET_MASK) < new_offset)
+        {
+            sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+            reference                   = interval & ESA_MF_PARENT_MASK;
+            interval                    = sa_parent_link[reference];
+        }
+    }
+
+    memset(matchfinder_ctx->prefetch, 0, sizeof(matchfinder_ctx->prefetch));
+
+    for (uint64_t position = target_position - prefetch_distance * 8; position != target_position; position += 1)
+    {
+        uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+
+        esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
+        esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+    }
+}
+
+void esa_matchfinder_advance(void * mf, int32_t count)
+{
+    if (((ESA_MF_CONTEXT *)mf)->deferred_count != 0)
+    {
+        esa_matchfinder_apply_deferred_updates((ESA_MF_CONTEXT *)mf);
+    }
+
+    if (count >= /*ESA_MF_ADVANCE_BACKWARDS_THRESHOLD*/ 64)
+    {
+        esa_matchfinder_advance_backwards(mf, count);
+        return;
+    }
+
+    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+
+    const ptrdiff_t                                 prefetch_distance   = 4;
+    const uint64_t                                  current_position    = matchfinder_ctx->position;
+    const uint64_t                                  target_position     = matchfinder_ctx->position += (uint64_t)count;
+
+    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+
+    for (uint64_t position = current_position; position < target_position; position += 1)
+    {
+        uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+
+        esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
+        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
+        esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+
+        const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+        uint64_t reference              = plcp_leaf_link[position];
+
+        while (reference != 0)
+        {
+            uint64_t interval           = sa_parent_link[reference];
+
+            sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+            reference                   = interval & ESA_MF_PARENT_MASK;
+        }
+    }
+}
+
+static void esa_matchfinder_compute_lpf_bins
+(
+    const uint64_t * ESA_MF_RESTRICT    sa_parent_link,
+    const uint32_t * ESA_MF_RESTRICT    plcp_leaf_link,
+    uint8_t * ESA_MF_RESTRICT           bins,
+    ptrdiff_t * ESA_MF_RESTRICT         bin_counts,
+    int32_t * ESA_MF_RESTRICT           lengths,
+    int32_t * ESA_MF_RESTRICT           sources,
+    ptrdiff_t                           num_bins,
+    ptrdiff_t                           omp_block_start,
+    ptrdiff_t                           omp_block_size
+)
+{
+    memset(bin_counts, 0, (size_t)num_bins * sizeof(ptrdiff_t));
+
+    for (ptrdiff_t position = omp_block_start; position < omp_block_start + omp_block_size; position += 1)
+    {
+        uint64_t reference = plcp_leaf_link[position];
+
+        lengths[position] = 0;
+        sources[position] = 0;
+        bins[position]    = UINT8_MAX;
+
+        if (reference != 0)
+        {
+            uint64_t parent;
+            while ((parent = sa_parent_link[reference] & ESA_MF_PARENT_MASK) != 0) { reference = parent; }
+
+            uint8_t bin = (uint8_t)(((uint32_t)reference * UINT32_C(2654435761)) % (uint32_t)num_bins);
+
+            bins[position] = bin; bin_counts[bin] += 1;
+        }
+    }
+}
+
+static void esa_matchfinder_compute_lpf_scatter
+(
+    const uint8_t * ESA_MF_RESTRICT     bins,
+    const uint8_t * ESA_MF_RESTRICT     bin_owners,
+    uint32_t * ESA_MF_RESTRICT          positions,
+    ptrdiff_t * ESA_MF_RESTRICT         owner_cursors,
+    ptrdiff_t                           omp_block_start,
+    ptrdiff_t                           omp_block_size
+)
+{
+    for (ptrdiff_t position = omp_block_start; position < omp_block_start + omp_block_size; position += 1)
+    {
+        if (bins[position] != UINT8_MAX)
+        {
+            positions[owner_cursors[bin_owners[bins[position]]]++] = (uint32_t)position;
+        }
+    }
+}
+
+static void esa_matchfinder_compute_lpf_positions
+(
+    uint64_t * ESA_MF_RESTRICT          sa_parent_link,
+    const uint32_t * ESA_MF_RESTRICT    plcp_leaf_link,
+    const uint32_t * ESA_MF_RESTRICT    positions,
+    int32_t * ESA_MF_RESTRICT           lengths,
+    int32_t * ESA_MF_RESTRICT           sources,
+    uint64_t                            min_match_length,
+    ptrdiff_t                           start,
+    ptrdiff_t                           end
+)
+{
+    for (ptrdiff_t index = start; index < end; index += 1)
+    {
+        const ptrdiff_t position            = positions != NULL ? (ptrdiff_t)positions[index] : index;
+        const uint64_t  new_offset          = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
+        uint64_t        best_match          = 0;
+        uint64_t        reference           = plcp_leaf_link[position];
+
+        while (reference != 0)
+        {
+            const uint64_t interval         = sa_parent_link[reference];
+                  uint64_t match            = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+
+            match                           = interval & ESA_MF_OFFSET_MASK ? match : best_match;
+            best_match                      = best_match == 0               ? match : best_match;
+
+            sa_parent_link[reference]       = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
+            reference                       = interval & ESA_MF_PARENT_MASK;
+        }
+
+        lengths[position]                   = (int32_t)(best_match      );
+        sources[position]                   = (int32_t)(best_match >> 32);
+    }
+}
+
+typedef struct ESA_MF_LPF_TASK
+{
+    uint64_t *              sa_parent_link;
+    const uint32_t *        plcp_leaf_link;
+    uint8_t *               bins;
+    uint32_t *              positions;
+    ptrdiff_t *             bin_counts;
+    ptrdiff_t *             owner_cursors;
+    ptrdiff_t *             owner_starts;
+    int32_t *               lengths;
+    int32_t *               sources;
+    uint64_t                min_match_length;
+    ptrdiff_t               num_bins;
+    ptrdiff_t               n;
+    uint8_t                 bin_owners[UINT8_MAX];
+} ESA_MF_LPF_TASK;
+
+static void esa_matchfinder_compute_lpf_bins_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_LPF_TASK * lpf_task = (ESA_MF_LPF_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (lpf_task->n / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+    ptrdiff_t omp_block_size      = task < num_tasks - 1 ? omp_block_stride : lpf_task->n - omp_block_start;
+
+    esa_matchfinder_compute_lpf_bins(lpf_task->sa_parent_link, lpf_task->plcp_leaf_link, lpf_task->bins, lpf_task->bin_counts + task * lpf_task->num_bins, lpf_task->lengths, lpf_task->sources, lpf_task->num_bins, omp_block_start, omp_block_size);
+}
+
+static void esa_matchfinder_compute_lpf_scatter_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_LPF_TASK * lpf_task = (ESA_MF_LPF_TASK *)task_context;
+
+    ptrdiff_t omp_block_stride    = (lpf_task->n / num_tasks) & (-16);
+    ptrdiff_t omp_block_start     = task * omp_block_stride;
+    ptrdiff_t omp_block_size      = task < num_tasks - 1 ? omp_block_stride : lpf_task->n - omp_block_start;
+
+    esa_matchfinder_compute_lpf_scatter(lpf_task->bins, lpf_task->bin_owners, lpf_task->positions, lpf_task->owner_cursors + task * num_tasks, omp_block_start, omp_block_size);
+}
+
+static void esa_matchfinder_compute_lpf_owned_task(void * task_context, int32_t task, int32_t num_tasks)
+{
+    ESA_MF_LPF_TASK * lpf_task = (ESA_MF_LPF_TASK *)task_context;
+
+    ESA_MF_UNUSED(num_tasks);
+
+    esa_matchfinder_compute_lpf_positions(lpf_task->sa_parent_link, lpf_task->plcp_leaf_link, lpf_task->positions, lpf_task->lengths, lpf_task->sources, lpf_task->min_match_length, lpf_task->owner_starts[task], lpf_task->owner_starts[task + 1]);
+}
+
+static void esa_matchfinder_assign_lpf_bins(ESA_MF_LPF_TASK * lpf_task, ptrdiff_t num_tasks)
+{
+    ptrdiff_t bin_sizes[UINT8_MAX], owner_sizes[ESA_MF_NUM_THREADS_MAX] = { 0 };
+
+    for (ptrdiff_t bin = 0; bin < lpf_task->num_bins; bin += 1)
+    {
+        bin_sizes[bin] = 0;
+        for (ptrdiff_t task = 0; task < num_tasks; task += 1) { bin_sizes[bin] += lpf_task->bin_counts[task * lpf_task->num_bins + bin]; }
+    }
+
+    for (ptrdiff_t assigned = 0; assigned < lpf_task->num_bins; assigned += 1)
+    {
+        ptrdiff_t largest_bin = 0, smallest_owner = 0;
+
+        for (ptrdiff_t bin = 1; bin < lpf_task->num_bins; bin += 1) { largest_bin = bin_sizes[bin] > bin_sizes[largest_bin] ? bin : largest_bin; }
+        for (ptrdiff_t owner = 1; owner < num_tasks; owner += 1) { smallest_owner = owner_sizes[owner] < owner_sizes[smallest_owner] ? owner : smallest_owner; }
+
+        lpf_task->bin_owners[largest_bin] = (uint8_t)smallest_owner;
+        owner_sizes[smallest_owner] += bin_sizes[largest_bin]; bin_sizes[largest_bin] = -1;
+    }
+
+    lpf_task->owner_starts[0] = 0;
+    for (ptrdiff_t owner = 0; owner < num_tasks; owner += 1) { lpf_task->owner_starts[owner + 1] = lpf_task->owner_starts[owner] + owner_sizes[owner]; }
+    for (ptrdiff_t owner = 0; owner < num_tasks; owner += 1) { owner_sizes[owner] = lpf_task->owner_starts[owner]; }
+
+    for (ptrdiff_t task = 0; task < num_tasks; task += 1)
+    {
+        for (ptrdiff_t owner = 0; owner < num_tasks; owner += 1) { lpf_task->owner_cursors[task * num_tasks + owner] = owner_sizes[owner]; }
+        for (ptrdiff_t bin = 0; bin < lpf_task->num_bins; bin += 1) { owner_sizes[lpf_task->bin_owners[bin]] += lpf_task->bin_counts[task * lpf_task->num_bins + bin]; }
+    }
+}
+
+static void esa_matchfinder_compute_lpf_omp
+(
+    const ESA_MF_CONTEXT *              matchfinder_ctx,
+    uint64_t * ESA_MF_RESTRICT          sa_parent_link,
+    const uint32_t * ESA_MF_RESTRICT    plcp_leaf_link,
+    int32_t * ESA_MF_RESTRICT           lengths,
+    int32_t * ESA_MF_RESTRICT           sources,
+    uint64_t                            min_match_length,
+    ptrdiff_t                           n,
+    ptrdiff_t                           num_threads
+)
+{
+    num_threads = esa_matchfinder_num_tasks(num_threads, n, ESA_MF_LPF_GRAIN_SIZE);
+
+    ptrdiff_t   num_bins    = num_threads * ESA_MF_LPF_BINS_PER_THREAD < UINT8_MAX ? num_threads * ESA_MF_LPF_BINS_PER_THREAD : UINT8_MAX;
+    uint8_t *   storage     = num_threads > 1
+        ? (uint8_t *)esa_matchfinder_alloc_aligned(
+            (size_t)n * (sizeof(uint32_t) + sizeof(uint8_t)) +
+            ((size_t)num_threads * (size_t)(num_bins + num_threads) + (size_t)num_threads + 1) * sizeof(ptrdiff_t), ESA_MF_STORAGE_PADDING)
+        : NULL;
+
+    if (storage == NULL)
+    {
+        esa_matchfinder_compute_lpf_positions(sa_parent_link, plcp_leaf_link, NULL, lengths, sources, min_match_length, 0, n);
+    }
+    else
+    {
+        ESA_MF_LPF_TASK lpf_task;
+
+        lpf_task.sa_parent_link     = sa_parent_link;
+        lpf_task.plcp_leaf_link     = plcp_leaf_link;
+        lpf_task.bin_counts         = (ptrdiff_t *)(void *)storage;
+        lpf_task.owner_cursors      = lpf_task.bin_counts + num_threads * num_bins;
+        lpf_task.owner_starts       = lpf_task.owner_cursors + num_threads * num_threads;
+        lpf_task.positions          = (uint32_t *)(void *)(lpf_task.owner_starts + num_threads + 1);
+        lpf_task.bins               = (uint8_t *)(void *)(lpf_task.positions + n);
+        lpf_task.lengths            = lengths;
+        lpf_task.sources            = sources;
+        lpf_task.min_match_length   = min_match_length;
+        lpf_task.num_bins           = num_bins;
+        lpf_task.n                  = n;
+
+        esa_matchfinder_run_tasks(matchfinder_ctx, num_threads, esa_matchfinder_compute_lpf_bins_task, &lpf_task);
+        esa_matchfinder_assign_lpf_bins(&lpf_task, num_threads);
+        esa_matchfinder_run_tasks(matchfinder_ctx, num_threads, esa_matchfinder_compute_lpf_scatter_task, &lpf_task);
+        esa_matchfinder_run_tasks(matchfinder_ctx, num_threads, esa_matchfinder_compute_lpf_owned_task, &lpf_task);
+
+        esa_matchfinder_free_aligned(storage);
+    }
+}
+
+int32_t esa_matchfinder_compute_lpf(void * mf, int32_t * lengths, int32_t * sources)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if ((matchfinder_ctx == NULL) || (matchfinder_ctx->block_size < 0) || (lengths == NULL) || (sources == NULL))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    if (matchfinder_ctx->block_size == 0)
+    {
+        return ESA_MATCHFINDER_NO_ERROR;
+    }
+
+    esa_matchfinder_rewind(mf, 0);
+
+    esa_matchfinder_compute_lpf_omp(
+        matchfinder_ctx,
+        matchfinder_ctx->sa_parent_link,
+        matchfinder_ctx->plcp_leaf_link,
+        lengths,
+        sources,
+        matchfinder_ctx->min_match_length_minus_1,
+        matchfinder_ctx->block_size,
+        matchfinder_ctx->parse_num_threads);
+
+    esa_matchfinder_set_position(matchfinder_ctx, (uint64_t)matchfinder_ctx->block_size);
+    esa_matchfinder_rewind(mf, 0);
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+static uint64_t esa_matchfinder_query_predecessor(const ESA_MF_CONTEXT * ESA_MF_RESTRICT matchfinder_ctx, uint64_t left, uint64_t right, uint64_t position)
+{
+    const uint64_t * ESA_MF_RESTRICT const  query_bitmap    = matchfinder_ctx->query_bitmap;
+    const uint32_t * ESA_MF_RESTRICT const  query_ranks     = matchfinder_ctx->query_ranks;
+    const int64_t                           query_words     = matchfinder_ctx->query_words;
+    const int64_t                           query_levels    = matchfinder_ctx->query_levels;
+
+    const uint64_t  target          = position - 1;
+    uint64_t        value           = 0;
+    int64_t         fallback_level  = -1;
+    uint64_t        fallback_left   = 0;
+    uint64_t        fallback_right  = 0;
+    uint64_t        fallback_value  = 0;
+    int64_t         level;
+
+    for (level = 0; level < query_levels; level += 1)
+    {
+        const int64_t   shift       = query_levels - level - 1;
+        const uint64_t  word_left   = (uint64_t)level * (uint64_t)query_words + (left  >> 6);
+        const uint64_t  word_right  = (uint64_t)level * (uint64_t)query_words + (right >> 6);
+        const uint64_t  ones_left   = query_ranks[word_left ] + esa_matchfinder_popcount64(query_bitmap[word_left ] & (((uint64_t)1 << (left  & 63)) - 1));
+        const uint64_t  ones_right  = query_ranks[word_right] + esa_matchfinder_popcount64(query_bitmap[word_right] & (((uint64_t)1 << (right & 63)) - 1));
+
+        if ((target >> shift) & 1)
+        {
+            if (left - ones_left < right - ones_right)
+            {
+                fallback_level  = level;
+                fallback_left   = left  - ones_left;
+                fallback_right  = right - ones_right;
+                fallback_value  = value;
+            }
+
+            left    = matchfinder_ctx->query_zeros[level] + ones_left;
+            right   = matchfinder_ctx->query_zeros[level] + ones_right;
+            value  |= (uint64_t)1 << shift;
+        }
+        else
+        {
+            left    = left  - ones_left;
+            right   = right - ones_right;
+        }
+
+        if (left >= right) { break; }
+    }
+
+    if (level == query_levels)
+    {
+        return target;
+    }
+
+    if (fallback_level < 0)
+    {
+        return 0;
+    }
+
+    left = fallback_left; right = fallback_right; value = fallback_value;
+
+    for (level = fallback_level + 1; level < query_levels; level += 1)
+    {
+        const int64_t   shift       = query_levels - level - 1;
+        const uint64_t  word_left   = (uint64_t)level * (uint64_t)query_words + (left  >> 6);
+        const uint64_t  word_right  = (uint64_t)level * (uint64_t)query_words + (right >> 6);
+        const uint64_t  ones_left   = query_ranks[word_left ] + esa_matchfinder_popcount64(query_bitmap[word_left ] & (((uint64_t)1 << (left  & 63)) - 1));
+        const uint64_t  ones_right  = query_ranks[word_right] + esa_matchfinder_popcount64(query_bitmap[word_right] & (((uint64_t)1 << (right & 63)) - 1));
+
+        if (ones_left < ones_right)
+        {
+            left    = matchfinder_ctx->query_zeros[level] + ones_left;
+            right   = matchfinder_ctx->query_zeros[level] + ones_right;
+            value  |= (uint64_t)1 << shift;
+        }
+        else
+        {
+            left    = left  - ones_left;
+            right   = right - ones_right;
+        }
+    }
+
+    return value;
+}
+
+ESA_MATCHFINDER_MATCH * esa_matchfinder_query(const void * mf, int32_t position, ESA_MATCHFINDER_MATCH * matches)
+{
+    const ESA_MF_CONTEXT * ESA_MF_RESTRICT const    matchfinder_ctx     = (const ESA_MF_CONTEXT *)mf;
+
+    if ((matchfinder_ctx == NULL) || (matchfinder_ctx->query_levels == 0) || (position < 0) || (position >= matchfinder_ctx->block_size) || (matches == NULL))
+    {
+        return NULL;
+    }
+
+    const uint64_t * ESA_MF_RESTRICT const          sa_parent_link      = matchfinder_ctx->sa_parent_link;
+    const uint32_t * ESA_MF_RESTRICT const          plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+    const uint32_t * ESA_MF_RESTRICT const          query_intervals     = matchfinder_ctx->query_intervals;
+    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT         next_match          = matches;
+
+    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
+    uint64_t best_match             = (uint64_t)(uint32_t)-1;
+    uint64_t best_offset            = 0;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0 && best_offset + 1 < (uint64_t)position)
+    {
+        const uint64_t interval     = sa_parent_link[reference];
+        const uint64_t offset       = esa_matchfinder_query_predecessor(matchfinder_ctx, query_intervals[2 * reference + 0], query_intervals[2 * reference + 1], (uint64_t)position);
+        const uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + (offset << 32);
+
+        next_match->length          = (int32_t)(match      );
+        next_match->offset          = (int32_t)(match >> 32);
+
+        next_match                 += match > best_match;
+        best_match                  = match;
+        best_offset                 = offset;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    return next_match;
+}
+
+void * esa_matchfinder_cursor_create(void * mf)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+
+    if ((matchfinder_ctx == NULL) || (matchfinder_ctx->block_size < 0))
+    {
+        return NULL;
+    }
+
+    if (matchfinder_ctx->cursor_parent_link == NULL)
+    {
+        matchfinder_ctx->cursor_parent_link = (uint64_t *)esa_matchfinder_alloc_aligned(((size_t)matchfinder_ctx->max_block_size + (size_t)esa_matchfinder_hot_intervals_size(matchfinder_ctx->max_block_size)) * sizeof(uint64_t), ESA_MF_STORAGE_PADDING);
+
+        if (matchfinder_ctx->cursor_parent_link == NULL)
+        {
+            return NULL;
+        }
+
+        esa_matchfinder_copy_cursor_parent_link(matchfinder_ctx);
+    }
+
+    ESA_MF_CURSOR * cursor  = (ESA_MF_CURSOR *)esa_matchfinder_alloc_aligned(sizeof(ESA_MF_CURSOR), ESA_MF_STORAGE_PADDING);
+    uint32_t *      offsets = (uint32_t *)esa_matchfinder_alloc_aligned(((size_t)matchfinder_ctx->max_block_size + (size_t)esa_matchfinder_hot_intervals_size(matchfinder_ctx->max_block_size)) * sizeof(uint32_t), ESA_MF_STORAGE_PADDING);
+
+    if (cursor != NULL && offsets != NULL)
+    {
+        cursor->matchfinder_ctx = matchfinder_ctx;
+        cursor->offsets         = offsets;
+        cursor->position        = (uint64_t)-1;
+
+        esa_matchfinder_cursor_rewind(cursor, 0);
+
+        return cursor;
+    }
+
+    esa_matchfinder_free_aligned(offsets);
+    esa_matchfinder_free_aligned(cursor);
+
+    return NULL;
+}
+
+void esa_matchfinder_cursor_destroy(void * mf_cursor)
+{
+    ESA_MF_CURSOR * cursor = (ESA_MF_CURSOR *)mf_cursor;
+
+    if (cursor != NULL)
+    {
+        esa_matchfinder_free_aligned(cursor->offsets);
+        esa_matchfinder_free_aligned(cursor);
+    }
+}
+
+int32_t esa_matchfinder_cursor_get_position(void * mf_cursor)
+{
+    return (int32_t)((ESA_MF_CURSOR *)mf_cursor)->position;
+}
+
+int32_t esa_matchfinder_cursor_rewind(void * mf_cursor, int32_t position)
+{
+    ESA_MF_CURSOR * cursor = (ESA_MF_CURSOR *)mf_cursor;
+
+    if ((cursor == NULL) || (position < 0) || (position > 0 && position >= cursor->matchfinder_ctx->block_size))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
+    }
+
+    const uint64_t * ESA_MF_RESTRICT const  cursor_parent_link  = cursor->matchfinder_ctx->cursor_parent_link;
+    const uint32_t * ESA_MF_RESTRICT const  plcp_leaf_link      = cursor->matchfinder_ctx->plcp_leaf_link;
+    uint32_t * ESA_MF_RESTRICT const        offsets             = cursor->offsets;
+
+    memset(offsets, 0, ((size_t)cursor->matchfinder_ctx->block_size + (size_t)cursor->matchfinder_ctx->hot_intervals_size) * sizeof(uint32_t));
+    offsets[0] = UINT32_MAX;
+
+    for (uint64_t next_position = (uint64_t)position; next_position-- > 1; )
+    {
+        uint64_t reference = plcp_leaf_link[next_position];
+
+        while (offsets[reference] == 0)
+        {
+            offsets[reference]  = (uint32_t)next_position;
+            reference           = cursor_parent_link[reference] & ESA_MF_PARENT_MASK;
+        }
+    }
+
+    cursor->position = (uint64_t)position;
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+ESA_MATCHFINDER_MATCH * esa_matchfinder_cursor_find_all_matches(void * mf_cursor, ESA_MATCHFINDER_MATCH * matches)
+{
+    ESA_MF_CURSOR * ESA_MF_RESTRICT const           cursor              = (ESA_MF_CURSOR *)mf_cursor;
+
+    const ptrdiff_t                                 prefetch_distance   = 16;
+    const uint64_t                                  position            = cursor->position++;
+
+    const uint64_t * ESA_MF_RESTRICT const          cursor_parent_link  = cursor->matchfinder_ctx->cursor_parent_link;
+    const uint32_t * ESA_MF_RESTRICT const          plcp_leaf_link      = cursor->matchfinder_ctx->plcp_leaf_link;
+    uint32_t * ESA_MF_RESTRICT const                offsets             = cursor->offsets;
+    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT         next_match          = matches;
+
+    esa_matchfinder_prefetchr(&cursor_parent_link[plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchw(&offsets           [plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link    [position + 2 * prefetch_distance]);
+
+    const uint64_t min_match_length = (uint64_t)cursor->matchfinder_ctx->min_match_length_minus_1;
+    uint64_t best_match             = (uint64_t)(uint32_t)-1;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = cursor_parent_link[reference];
+        const uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((uint64_t)offsets[reference] << 32);
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)next_match = match;
+        }
+        else
+#endif
+        {
+            next_match->length      = (int32_t)(match      );
+            next_match->offset      = (int32_t)(match >> 32);
+        }
+
+        next_match                 += match > best_match;
+        best_match                  = match;
+
+        offsets[reference]          = (uint32_t)position;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    return next_match;
+}
+
+ESA_MATCHFINDER_MATCH * esa_matchfinder_cursor_find_all_matches_in_window(void * mf_cursor, ESA_MATCHFINDER_MATCH * matches, uint64_t window_size)
+{
+    ESA_MF_CURSOR * ESA_MF_RESTRICT const           cursor              = (ESA_MF_CURSOR *)mf_cursor;
+
+    const ptrdiff_t                                 prefetch_distance   = 16;
+    const uint64_t                                  position            = cursor->position++;
+
+    const uint64_t * ESA_MF_RESTRICT const          cursor_parent_link  = cursor->matchfinder_ctx->cursor_parent_link;
+    const uint32_t * ESA_MF_RESTRICT const          plcp_leaf_link      = cursor->matchfinder_ctx->plcp_leaf_link;
+    uint32_t * ESA_MF_RESTRICT const                offsets             = cursor->offsets;
+    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT         next_match          = matches;
+
+    esa_matchfinder_prefetchr(&cursor_parent_link[plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchw(&offsets           [plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link    [position + 2 * prefetch_distance]);
+
+    const uint64_t min_match_length = (uint64_t)cursor->matchfinder_ctx->min_match_length_minus_1;
+    uint64_t best_match             = (position > window_size ? (position - window_size) << 32 : 0) + (uint64_t)(uint32_t)-1;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = cursor_parent_link[reference];
+        const uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((uint64_t)offsets[reference] << 32);
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)next_match = match;
+        }
+        else
+#endif
+        {
+            next_match->length      = (int32_t)(match      );
+            next_match->offset      = (int32_t)(match >> 32);
+        }
+
+        next_match                 += match > best_match;
+        best_match                  = match;
+
+        offsets[reference]          = (uint32_t)position;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    return next_match;
+}
+
+ESA_MATCHFINDER_MATCH esa_matchfinder_cursor_find_best_match(void * mf_cursor)
+{
+    ESA_MF_CURSOR * ESA_MF_RESTRICT const           cursor              = (ESA_MF_CURSOR *)mf_cursor;
+
+    const ptrdiff_t                                 prefetch_distance   = 16;
+    const uint64_t                                  position            = cursor->position++;
+
+    const uint64_t * ESA_MF_RESTRICT const          cursor_parent_link  = cursor->matchfinder_ctx->cursor_parent_link;
+    const uint32_t * ESA_MF_RESTRICT const          plcp_leaf_link      = cursor->matchfinder_ctx->plcp_leaf_link;
+    uint32_t * ESA_MF_RESTRICT const                offsets             = cursor->offsets;
+
+    esa_matchfinder_prefetchr(&cursor_parent_link[plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchw(&offsets           [plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link    [position + 2 * prefetch_distance]);
+
+    const uint64_t min_match_length = (uint64_t)cursor->matchfinder_ctx->min_match_length_minus_1;
+    uint64_t best_match             = 0;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = cursor_parent_link[reference];
+        const uint64_t offset       = offsets[reference];
+              uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + (offset << 32);
+
+        match                       = offset != 0                   ? match : best_match;
+        best_match                  = best_match == 0               ? match : best_match;
+
+        offsets[reference]          = (uint32_t)position;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    {
+        ESA_MATCHFINDER_MATCH match;
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)&match = best_match;
+        }
+        else
+#endif
+        {
+            match.length            = (int32_t)(best_match      );
+            match.offset            = (int32_t)(best_match >> 32);
+        }
+
+        return match;
+    }
+}
+
+ESA_MATCHFINDER_MATCH esa_matchfinder_cursor_find_best_match_in_window(void * mf_cursor, uint64_t window_size)
+{
+    ESA_MF_CURSOR * ESA_MF_RESTRICT const           cursor              = (ESA_MF_CURSOR *)mf_cursor;
+
+    const ptrdiff_t                                 prefetch_distance   = 16;
+    const uint64_t                                  position            = cursor->position++;
+
+    const uint64_t * ESA_MF_RESTRICT const          cursor_parent_link  = cursor->matchfinder_ctx->cursor_parent_link;
+    const uint32_t * ESA_MF_RESTRICT const          plcp_leaf_link      = cursor->matchfinder_ctx->plcp_leaf_link;
+    uint32_t * ESA_MF_RESTRICT const                offsets             = cursor->offsets;
+
+    esa_matchfinder_prefetchr(&cursor_parent_link[plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchw(&offsets           [plcp_leaf_link[position + 1 * prefetch_distance]]);
+    esa_matchfinder_prefetchr(&plcp_leaf_link    [position + 2 * prefetch_distance]);
+
+    const uint64_t min_match_length = (uint64_t)cursor->matchfinder_ctx->min_match_length_minus_1;
+    const uint64_t match_cutoff     = (position > window_size ? (position - window_size) << 32 : 0) + (uint64_t)(uint32_t)-1;
+
+    uint64_t best_match             = 0;
+    uint64_t reference              = plcp_leaf_link[position];
+
+    while (reference != 0)
+    {
+        const uint64_t interval     = cursor_parent_link[reference];
+              uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((uint64_t)offsets[reference] << 32);
+
+        match                       = match > match_cutoff          ? match : best_match;
+        best_match                  = best_match == 0               ? match : best_match;
+
+        offsets[reference]          = (uint32_t)position;
+        reference                   = interval & ESA_MF_PARENT_MASK;
+    }
+
+    {
+        ESA_MATCHFINDER_MATCH match;
+
+#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
+        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+        {
+            *(uint64_t *)(void *)&match = best_match;
+        }
+        else
+#endif
+        {
+            match.length            = (int32_t)(best_match      );
+            match.offset            = (int32_t)(best_match >> 32);
+        }
+
+        return match;
+    }
+}
+
+void esa_matchfinder_cursor_advance(void * mf_cursor, int32_t count)
+{
+    ESA_MF_CURSOR * ESA_MF_RESTRICT const           cursor              = (ESA_MF_CURSOR *)mf_cursor;
+
+    const uint64_t                                  current_position    = cursor->position;
+    const uint64_t                                  target_position     = cursor->position += (uint64_t)count;
+
+    const uint64_t * ESA_MF_RESTRICT const          cursor_parent_link  = cursor->matchfinder_ctx->cursor_parent_link;
+    const uint32_t * ESA_MF_RESTRICT const          plcp_leaf_link      = cursor->matchfinder_ctx->plcp_leaf_link;
+    uint32_t * ESA_MF_RESTRICT const                offsets             = cursor->offsets;
+
+    for (uint64_t position = target_position; position-- != current_position; )
+    {
+        uint64_t reference              = plcp_leaf_link[position];
+
+        while (offsets[reference] < (uint32_t)position)
+        {
+            offsets[reference]          = (uint32_t)position;
+            reference                   = cursor_parent_link[reference] & ESA_MF_PARENT_MASK;
+        }
+    }
+}
+
+void * esa_matchfinder_create_dictionary(const uint8_t * dictionary, int32_t dictionary_size, int32_t min_match_length, int32_t max_match_length)
+{
+    if ((dictionary == NULL) || (dictionary_size <= 0) || (dictionary_size > ESA_MATCHFINDER_MAX_BLOCK_SIZE))
+    {
+        return NULL;
+    }
+
+    ESA_MF_DICTIONARY * dictionary_ctx  = (ESA_MF_DICTIONARY *)esa_matchfinder_alloc_aligned(sizeof(ESA_MF_DICTIONARY), ESA_MF_STORAGE_PADDING);
+    ESA_MF_CONTEXT *    matchfinder_ctx = (ESA_MF_CONTEXT *)esa_matchfinder_create(dictionary_size, min_match_length, max_match_length);
+    uint8_t *           text            = (uint8_t *)esa_matchfinder_alloc_aligned((size_t)dictionary_size * sizeof(uint8_t), ESA_MF_STORAGE_PADDING);
+    uint32_t *          SA              = (uint32_t *)esa_matchfinder_alloc_aligned((size_t)dictionary_size * sizeof(uint32_t), ESA_MF_STORAGE_PADDING);
+    uint32_t *          buckets         = (uint32_t *)esa_matchfinder_alloc_aligned((ESA_MF_DICTIONARY_BUCKETS + 1) * sizeof(uint32_t), ESA_MF_STORAGE_PADDING);
+
+    if (dictionary_ctx != NULL && matchfinder_ctx != NULL && text != NULL && SA != NULL && buckets != NULL)
+    {
+        memcpy(text, dictionary, (size_t)dictionary_size * sizeof(uint8_t));
+
+        if (esa_matchfinder_parse_block(matchfinder_ctx, text, dictionary_size, 0, 0, SA) == ESA_MATCHFINDER_NO_ERROR)
+        {
+            esa_matchfinder_fast_forward(matchfinder_ctx->sa_parent_link, matchfinder_ctx->plcp_leaf_link, (uint64_t)dictionary_size);
+            matchfinder_ctx->position = (uint64_t)dictionary_size;
+
+            {
+                ptrdiff_t bucket = 0;
+                for (ptrdiff_t i = 0; i < dictionary_size; i += 1)
+                {
+                    ptrdiff_t key = (ptrdiff_t)text[SA[i]] * 257 + (SA[i] + 1 < (uint32_t)dictionary_size ? 1 + (ptrdiff_t)text[SA[i] + 1] : 0);
+                    while (bucket <= key) { buckets[bucket++] = (uint32_t)i; }
+                }
+                while (bucket <= ESA_MF_DICTIONARY_BUCKETS) { buckets[bucket++] = (uint32_t)dictionary_size; }
+            }
+
+            dictionary_ctx->matchfinder_ctx = matchfinder_ctx;
+            dictionary_ctx->text            = text;
+            dictionary_ctx->SA              = SA;
+            dictionary_ctx->buckets         = buckets;
+            dictionary_ctx->size            = dictionary_size;
+
+            return dictionary_ctx;
+        }
+    }
+
+    esa_matchfinder_free_aligned(buckets);
+    esa_matchfinder_free_aligned(SA);
+    esa_matchfinder_free_aligned(text);
+    esa_matchfinder_free_ctx(matchfinder_ctx);
+    esa_matchfinder_free_aligned(dictionary_ctx);
+
+    return NULL;
+}
+
+void esa_matchfinder_destroy_dictionary(void * dictionary)
+{
+    ESA_MF_DICTIONARY * dictionary_ctx = (ESA_MF_DICTIONARY *)dictionary;
 
-    while (reference != 0)
+    if (dictionary_ctx != NULL)
     {
-        const uint64_t interval     = sa_parent_link[reference];
-              uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+        esa_matchfinder_free_aligned(dictionary_ctx->buckets);
+        esa_matchfinder_free_aligned(dictionary_ctx->SA);
+        esa_matchfinder_free_aligned(dictionary_ctx->text);
+        esa_matchfinder_free_ctx(dictionary_ctx->matchfinder_ctx);
+        esa_matchfinder_free_aligned(dictionary_ctx);
+    }
+}
 
-        match                       = interval & ESA_MF_OFFSET_MASK ? match : best_match;
-        best_match                  = best_match == 0               ? match : best_match;
+int32_t esa_matchfinder_set_dictionary(void * mf, const void * dictionary)
+{
+    ESA_MF_CONTEXT *            matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
+    const ESA_MF_DICTIONARY *   dictionary_ctx  = (const ESA_MF_DICTIONARY *)dictionary;
 
-        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
-        reference                   = interval & ESA_MF_PARENT_MASK;
+    if ((matchfinder_ctx == NULL) || ((dictionary_ctx != NULL) && (
+        (dictionary_ctx->matchfinder_ctx->min_match_length != matchfinder_ctx->min_match_length) ||
+        (dictionary_ctx->matchfinder_ctx->max_match_length != matchfinder_ctx->max_match_length))))
+    {
+        return ESA_MATCHFINDER_BAD_PARAMETER;
     }
 
+    matchfinder_ctx->dictionary = dictionary;
+
+    return ESA_MATCHFINDER_NO_ERROR;
+}
+
+static ESA_MATCHFINDER_MATCH * esa_matchfinder_find_dictionary_matches
+(
+    const ESA_MF_DICTIONARY * ESA_MF_RESTRICT   dictionary_ctx,
+    const uint8_t * ESA_MF_RESTRICT             block,
+    uint64_t                                    position,
+    uint64_t                                    block_size,
+    uint64_t                                    max_match_length,
+    ESA_MATCHFINDER_MATCH * ESA_MF_RESTRICT     matches
+)
+{
+    const uint8_t * ESA_MF_RESTRICT const   text                = dictionary_ctx->text;
+    const uint32_t * ESA_MF_RESTRICT const  SA                  = dictionary_ctx->SA;
+    const uint64_t                          dictionary_size     = (uint64_t)dictionary_ctx->size;
+    const uint64_t                          match_limit         = block_size - position < max_match_length ? block_size - position : max_match_length;
+    const uint8_t * ESA_MF_RESTRICT const   pattern             = block + position;
+
+    if (match_limit < 2)
     {
-        ESA_MATCHFINDER_MATCH match;
+        return matches;
+    }
 
-#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
-        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+    const uint64_t  key         = (uint64_t)pattern[0] * 257 + 1 + (uint64_t)pattern[1];
+    uint64_t        left        = dictionary_ctx->buckets[key + 0];
+    uint64_t        right       = dictionary_ctx->buckets[key + 1];
+    uint64_t        left_lcp    = 0;
+    uint64_t        right_lcp   = 0;
+    uint64_t        best_index  = left;
+    uint64_t        best_lcp    = 0;
+
+    if (left == right)
+    {
+        return matches;
+    }
+
+    {
+        const uint64_t bucket_left = left, bucket_right = right;
+
+        left_lcp = right_lcp = 2;
+
+        while (left < right)
         {
-            *(uint64_t *)(void *)&match = best_match;
+            const uint64_t  middle  = left + ((right - left) >> 1);
+            const uint64_t  suffix  = SA[middle];
+            const uint64_t  limit   = dictionary_size - suffix < match_limit ? dictionary_size - suffix : match_limit;
+            uint64_t        lcp     = left_lcp < right_lcp ? left_lcp : right_lcp;
+
+            while (lcp < limit && text[suffix + lcp] == pattern[lcp]) { lcp += 1; }
+
+            if (lcp == match_limit)
+            {
+                left = right = middle; best_index = middle; best_lcp = lcp; break;
+            }
+
+            if (lcp == limit || text[suffix + lcp] < pattern[lcp])
+            {
+                left = middle + 1; left_lcp = lcp;
+            }
+            else
+            {
+                right = middle; right_lcp = lcp;
+            }
         }
-        else
-#endif
+
+        if (best_lcp == 0)
         {
-            match.length            = (int32_t)(best_match      );
-            match.offset            = (int32_t)(best_match >> 32);
+            if (left  > bucket_left ) { best_index = left - 1; best_lcp = left_lcp; }
+            if (right < bucket_right && right_lcp > best_lcp) { best_index = right; best_lcp = right_lcp; }
         }
+    }
 
-        return match;
+    {
+        const ESA_MF_CONTEXT * ESA_MF_RESTRICT const    matchfinder_ctx     = dictionary_ctx->matchfinder_ctx;
+        const uint64_t * ESA_MF_RESTRICT const          sa_parent_link      = matchfinder_ctx->sa_parent_link;
+        const uint64_t                                  min_match_length    = matchfinder_ctx->min_match_length_minus_1;
+
+        if (best_lcp <= min_match_length)
+        {
+            return matches;
+        }
+
+        uint64_t best_offset    = SA[best_index];
+        uint64_t reference      = matchfinder_ctx->plcp_leaf_link[best_offset];
+        uint64_t interval       = sa_parent_link[reference];
+
+        while (reference != 0 && min_match_length + (interval >> ESA_MF_LCP_SHIFT) >= best_lcp)
+        {
+            uint64_t offset     = (interval & ESA_MF_OFFSET_MASK) >> ESA_MF_OFFSET_SHIFT;
+
+            best_offset         = offset > best_offset ? offset : best_offset;
+            reference           = interval & ESA_MF_PARENT_MASK;
+            interval            = sa_parent_link[reference];
+        }
+
+        matches->length         = (int32_t)best_lcp;
+        matches->offset         = (int32_t)best_offset - (int32_t)dictionary_size;
+        matches                += 1;
+
+        while (reference != 0)
+        {
+            uint64_t offset     = (interval & ESA_MF_OFFSET_MASK) >> ESA_MF_OFFSET_SHIFT;
+
+            matches->length     = (int32_t)(min_match_length + (interval >> ESA_MF_LCP_SHIFT));
+            matches->offset     = (int32_t)offset - (int32_t)dictionary_size;
+            matches            += offset > best_offset;
+
+            best_offset         = offset > best_offset ? offset : best_offset;
+            reference           = interval & ESA_MF_PARENT_MASK;
+            interval            = sa_parent_link[reference];
+        }
     }
+
+    return matches;
 }
 
-ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match_in_window(void * mf, uint64_t window_size)
+ESA_MATCHFINDER_MATCH * esa_matchfinder_find_all_matches_with_dictionary(void * mf, ESA_MATCHFINDER_MATCH * matches)
 {
-    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
 
-    const ptrdiff_t                                 prefetch_distance   = 4;
-    const uint64_t                                  position            = matchfinder_ctx->position++;
+    if (matchfinder_ctx->dictionary == NULL)
+    {
+        return esa_matchfinder_find_all_matches(mf, matches);
+    }
 
-    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
-    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
-    uint64_t * ESA_MF_RESTRICT const                prefetch            = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+    ESA_MATCHFINDER_MATCH dictionary_matches[ESA_MATCHFINDER_MAX_MATCH_LENGTH];
 
-    esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
-    esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
-    esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+    const uint64_t                  position            = matchfinder_ctx->position;
+    ESA_MATCHFINDER_MATCH * const   dictionary_end      = esa_matchfinder_find_dictionary_matches(
+        (const ESA_MF_DICTIONARY *)matchfinder_ctx->dictionary,
+        matchfinder_ctx->block,
+        position,
+        (uint64_t)matchfinder_ctx->block_size,
+        (uint64_t)matchfinder_ctx->max_match_length,
+        dictionary_matches);
 
-    const uint64_t min_match_length = (uint64_t)matchfinder_ctx->min_match_length_minus_1;
-    const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-    const uint64_t match_cutoff     = (position > window_size ? (position - window_size) << 32 : 0) + (uint64_t)(uint32_t)-1;
+    ESA_MATCHFINDER_MATCH * const   matches_end         = esa_matchfinder_find_all_matches(mf, matches);
+    const int32_t                   max_length          = matches_end > matches ? matches[0].length : 0;
 
-    uint64_t best_match             = 0;
-    uint64_t reference              = plcp_leaf_link[position];
+    ptrdiff_t count = 0; while (dictionary_matches + count < dictionary_end && dictionary_matches[count].length > max_length) { count += 1; }
 
-    while (reference != 0)
+    if (count > 0)
     {
-        const uint64_t interval     = sa_parent_link[reference];
-              uint64_t match        = min_match_length + (interval >> ESA_MF_LCP_SHIFT) + ((interval & ESA_MF_OFFSET_MASK) << (32 - ESA_MF_OFFSET_SHIFT));
+        memmove(matches + count, matches, (size_t)(matches_end - matches) * sizeof(ESA_MATCHFINDER_MATCH));
+        memcpy(matches, dictionary_matches, (size_t)count * sizeof(ESA_MATCHFINDER_MATCH));
+    }
 
-        match                       = match > match_cutoff          ? match : best_match;
-        best_match                  = best_match == 0               ? match : best_match;
+    return matches_end + count;
+}
 
-        sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
-        reference                   = interval & ESA_MF_PARENT_MASK;
-    }
+ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match_with_dictionary(void * mf)
+{
+    ESA_MF_CONTEXT * matchfinder_ctx = (ESA_MF_CONTEXT *)mf;
 
+    if (matchfinder_ctx->dictionary == NULL)
     {
-        ESA_MATCHFINDER_MATCH match;
+        return esa_matchfinder_find_best_match(mf);
+    }
 
-#if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
-        if (offsetof(ESA_MATCHFINDER_MATCH, length) == 0 && offsetof(ESA_MATCHFINDER_MATCH, offset) == 4)
+    ESA_MATCHFINDER_MATCH dictionary_matches[ESA_MATCHFINDER_MAX_MATCH_LENGTH];
+
+    const uint64_t                  position            = matchfinder_ctx->position;
+    ESA_MATCHFINDER_MATCH * const   dictionary_end      = esa_matchfinder_find_dictionary_matches(
+        (const ESA_MF_DICTIONARY *)matchfinder_ctx->dictionary,
+        matchfinder_ctx->block,
+        position,
+        (uint64_t)matchfinder_ctx->block_size,
+        (uint64_t)matchfinder_ctx->max_match_length,
+        dictionary_matches);
+
+    ESA_MATCHFINDER_MATCH           match               = esa_matchfinder_find_best_match(mf);
+
+    return dictionary_end > dictionary_matches && dictionary_matches[0].length > match.length ? dictionary_matches[0] : match;
+}
+
+static void esa_matchfinder_pipeline_worker(ESA_MF_PIPELINE * pipeline)
+{
+    esa_matchfinder_mutex_lock(&pipeline->mutex);
+
+    for (;;)
+    {
+        while (!pipeline->pending && !pipeline->terminate)
         {
-            *(uint64_t *)(void *)&match = best_match;
+            esa_matchfinder_condition_wait(&pipeline->condition, &pipeline->mutex);
         }
-        else
-#endif
+
+        if (pipeline->terminate)
         {
-            match.length            = (int32_t)(best_match      );
-            match.offset            = (int32_t)(best_match >> 32);
+            break;
         }
 
-        return match;
+        void *          mf          = pipeline->matchfinders[pipeline->current ^ 1];
+        const uint8_t * block       = pipeline->block;
+        int32_t         block_size  = pipeline->block_size;
+
+        esa_matchfinder_mutex_unlock(&pipeline->mutex);
+
+        int32_t         result      = esa_matchfinder_parse(mf, block, block_size);
+
+        esa_matchfinder_mutex_lock(&pipeline->mutex);
+
+        pipeline->block_result      = result;
+        pipeline->pending           = 0;
+        pipeline->completed         = 1;
+
+        esa_matchfinder_condition_broadcast(&pipeline->condition);
     }
+
+    esa_matchfinder_mutex_unlock(&pipeline->mutex);
 }
 
-static void esa_matchfinder_advance_backwards(void * mf, int32_t count)
+#if defined(_WIN32)
+
+static DWORD WINAPI esa_matchfinder_pipeline_thread(LPVOID pipeline)
 {
-    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+    esa_matchfinder_pipeline_worker((ESA_MF_PIPELINE *)pipeline); return 0;
+}
 
-    const ptrdiff_t                                 prefetch_distance   = 4;
-    const uint64_t                                  current_position    = matchfinder_ctx->position;
-    const uint64_t                                  target_position     = matchfinder_ctx->position += (uint64_t)count;
+#else
 
-    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
-    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+static void * esa_matchfinder_pipeline_thread(void * pipeline)
+{
+    esa_matchfinder_pipeline_worker((ESA_MF_PIPELINE *)pipeline); return NULL;
+}
 
-    memset(matchfinder_ctx->prefetch, 0, sizeof(matchfinder_ctx->prefetch));
+#endif
 
-    for (uint64_t position = target_position + prefetch_distance * 8; position-- != target_position; )
+void * esa_matchfinder_create_pipeline(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads)
+{
+    ESA_MF_PIPELINE * pipeline = (ESA_MF_PIPELINE *)esa_matchfinder_alloc_aligned(sizeof(ESA_MF_PIPELINE), ESA_MF_STORAGE_PADDING);
+
+    if (pipeline == NULL)
     {
-        uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+        return NULL;
+    }
 
-        esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position - 8 * prefetch_distance])]);
-        esa_matchfinder_prefetchr(&plcp_leaf_link[position - 9 * prefetch_distance]);
+    memset(pipeline, 0, sizeof(ESA_MF_PIPELINE));
+
+    for (ptrdiff_t index = 0; index < 2; index += 1)
+    {
+#if defined(_OPENMP)
+        pipeline->matchfinders[index] = num_threads != 1
+            ? esa_matchfinder_create_omp(max_block_size, min_match_length, max_match_length, num_threads)
+            : esa_matchfinder_create(max_block_size, min_match_length, max_match_length);
+#else
+        pipeline->matchfinders[index] = num_threads != 1
+            ? esa_matchfinder_create_parallel(max_block_size, min_match_length, max_match_length, num_threads, NULL, NULL)
+            : esa_matchfinder_create(max_block_size, min_match_length, max_match_length);
+#endif
     }
 
-    for (uint64_t position = target_position; position-- != current_position; )
+    if (pipeline->matchfinders[0] != NULL && pipeline->matchfinders[1] != NULL)
     {
-        if (position >= 8 * prefetch_distance)
+        if (esa_matchfinder_mutex_init(&pipeline->mutex) == 0)
         {
-            uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
-
-            esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
-            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
-            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
-            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
-            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
-            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
-            esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position - 8 * prefetch_distance])]);
-            esa_matchfinder_prefetchr(&plcp_leaf_link[position - 9 * prefetch_distance]);
-        }
+            if (esa_matchfinder_condition_init(&pipeline->condition) == 0)
+            {
+#if defined(_WIN32)
+                pipeline->thread = CreateThread(NULL, 0, esa_matchfinder_pipeline_thread, pipeline, 0, NULL);
+                if (pipeline->thread != NULL)
+#else
+                if (pthread_create(&pipeline->thread, NULL, esa_matchfinder_pipeline_thread, pipeline) == 0)
+#endif
+                {
+                    return pipeline;
+                }
 
-        const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-        uint64_t reference              = plcp_leaf_link[position];
-        uint64_t interval               = sa_parent_link[reference];
+                esa_matchfinder_condition_destroy(&pipeline->condition);
+            }
 
-        while ((interval & ESA_MF_OFFSET_MASK) < new_offset)
-        {
-            sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
-            reference                   = interval & ESA_MF_PARENT_MASK;
-            interval                    = sa_parent_link[reference];
+            esa_matchfinder_mutex_destroy(&pipeline->mutex);
         }
     }
 
-    memset(matchfinder_ctx->prefetch, 0, sizeof(matchfinder_ctx->prefetch));
+    esa_matchfinder_destroy(pipeline->matchfinders[1]);
+    esa_matchfinder_destroy(pipeline->matchfinders[0]);
+    esa_matchfinder_free_aligned(pipeline);
 
-    for (uint64_t position = target_position - prefetch_distance * 8; position != target_position; position += 1)
+    return NULL;
+}
+
+void esa_matchfinder_destroy_pipeline(void * mf_pipeline)
+{
+    ESA_MF_PIPELINE * pipeline = (ESA_MF_PIPELINE *)mf_pipeline;
+
+    if (pipeline != NULL)
     {
-        uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+        esa_matchfinder_mutex_lock(&pipeline->mutex);
+        pipeline->terminate = 1;
+        esa_matchfinder_condition_broadcast(&pipeline->condition);
+        esa_matchfinder_mutex_unlock(&pipeline->mutex);
+
+#if defined(_WIN32)
+        WaitForSingleObject(pipeline->thread, INFINITE);
+        CloseHandle(pipeline->thread);
+#else
+        pthread_join(pipeline->thread, NULL);
+#endif
 
-        esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
-        esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+        esa_matchfinder_condition_destroy(&pipeline->condition);
+        esa_matchfinder_mutex_destroy(&pipeline->mutex);
+
+        esa_matchfinder_destroy(pipeline->matchfinders[1]);
+        esa_matchfinder_destroy(pipeline->matchfinders[0]);
+        esa_matchfinder_free_aligned(pipeline);
     }
 }
 
-void esa_matchfinder_advance(void * mf, int32_t count)
+int32_t esa_matchfinder_pipeline_submit(void * mf_pipeline, const uint8_t * block, int32_t block_size)
 {
-    if (count >= /*ESA_MF_ADVANCE_BACKWARDS_THRESHOLD*/ 64)
+    ESA_MF_PIPELINE *   pipeline    = (ESA_MF_PIPELINE *)mf_pipeline;
+    int32_t             result      = ESA_MATCHFINDER_BAD_PARAMETER;
+
+    if ((pipeline != NULL) && (block != NULL) && (block_size >= 0))
     {
-        esa_matchfinder_advance_backwards(mf, count);
-        return;
-    }
+        esa_matchfinder_mutex_lock(&pipeline->mutex);
 
-    ESA_MF_CONTEXT * ESA_MF_RESTRICT const          matchfinder_ctx     = (ESA_MF_CONTEXT *)mf;
+        if (!pipeline->pending && !pipeline->completed)
+        {
+            pipeline->block     = block;
+            pipeline->block_size = block_size;
+            pipeline->pending   = 1;
+            result              = ESA_MATCHFINDER_NO_ERROR;
 
-    const ptrdiff_t                                 prefetch_distance   = 4;
-    const uint64_t                                  current_position    = matchfinder_ctx->position;
-    const uint64_t                                  target_position     = matchfinder_ctx->position += (uint64_t)count;
+            esa_matchfinder_condition_broadcast(&pipeline->condition);
+        }
 
-    uint64_t * ESA_MF_RESTRICT const                sa_parent_link      = matchfinder_ctx->sa_parent_link;
-    uint32_t * ESA_MF_RESTRICT const                plcp_leaf_link      = matchfinder_ctx->plcp_leaf_link;
+        esa_matchfinder_mutex_unlock(&pipeline->mutex);
+    }
 
-    for (uint64_t position = current_position; position < target_position; position += 1)
-    {
-        uint64_t * ESA_MF_RESTRICT const prefetch = &matchfinder_ctx->prefetch[position & (prefetch_distance - 1)][0];
+    return result;
+}
 
-        esa_matchfinder_prefetchw(&sa_parent_link[              (sa_parent_link[prefetch[0]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[0] = (sa_parent_link[prefetch[1]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[1] = (sa_parent_link[prefetch[2]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[2] = (sa_parent_link[prefetch[3]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[3] = (sa_parent_link[prefetch[4]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[4] = (sa_parent_link[prefetch[5]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[5] = (sa_parent_link[prefetch[6]] & ESA_MF_PARENT_MASK)]);
-        esa_matchfinder_prefetchw(&sa_parent_link[prefetch[6] = (plcp_leaf_link[position + 8 * prefetch_distance])]);
-        esa_matchfinder_prefetchr(&plcp_leaf_link[position + 9 * prefetch_distance]);
+void * esa_matchfinder_pipeline_next_block(void * mf_pipeline)
+{
+    ESA_MF_PIPELINE *   pipeline    = (ESA_MF_PIPELINE *)mf_pipeline;
+    void *              mf          = NULL;
 
-        const uint64_t new_offset       = (uint64_t)position << ESA_MF_OFFSET_SHIFT;
-        uint64_t reference              = plcp_leaf_link[position];
+    if (pipeline != NULL)
+    {
+        esa_matchfinder_mutex_lock(&pipeline->mutex);
 
-        while (reference != 0)
+        while (pipeline->pending)
         {
-            uint64_t interval           = sa_parent_link[reference];
+            esa_matchfinder_condition_wait(&pipeline->condition, &pipeline->mutex);
+        }
 
-            sa_parent_link[reference]   = (interval & (~ESA_MF_OFFSET_MASK)) + new_offset;
-            reference                   = interval & ESA_MF_PARENT_MASK;
+        if (pipeline->completed)
+        {
+            pipeline->completed = 0;
+            pipeline->current  ^= 1;
+
+            mf = pipeline->block_result == ESA_MATCHFINDER_NO_ERROR ? pipeline->matchfinders[pipeline->current] : NULL;
         }
+
+        esa_matchfinder_mutex_unlock(&pipeline->mutex);
     }
+
+    return mf;
 }
 
 #if defined(__clang__)
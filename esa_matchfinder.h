@@ -32,10 +32,19 @@ Please see the file LICENSE for full copyright and license details.
 #define ESA_MATCHFINDER_NO_ERROR            (0)
 #define ESA_MATCHFINDER_BAD_PARAMETER       (-1)
 
+#define ESA_MATCHFINDER_SORT_FULL           (0)
+#define ESA_MATCHFINDER_SORT_BOUNDED        (1)
+
+#define ESA_MATCHFINDER_ISA_GENERIC         (0)
+#define ESA_MATCHFINDER_ISA_SSE2            (1)
+#define ESA_MATCHFINDER_ISA_AVX2            (2)
+#define ESA_MATCHFINDER_ISA_AVX512          (3)
+#define ESA_MATCHFINDER_ISA_NEON            (4)
+
 #define ESA_MATCHFINDER_VERSION_MAJOR       1
-#define ESA_MATCHFINDER_VERSION_MINOR       2
+#define ESA_MATCHFINDER_VERSION_MINOR       3
 #define ESA_MATCHFINDER_VERSION_PATCH       0
-#define ESA_MATCHFINDER_VERSION_STRING      "1.2.0"
+#define ESA_MATCHFINDER_VERSION_STRING      "1.3.0"
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +58,25 @@ extern "C" {
         int32_t     offset;
     } ESA_MATCHFINDER_MATCH;
 
+    /**
+    * The task executed by the parallel for callback.
+    * @param task_context The opaque task context.
+    * @param task The index of the task (from 0 to num_tasks - 1).
+    * @param num_tasks The total number of tasks.
+    */
+    typedef void (* esa_matchfinder_task)(void * task_context, int32_t task, int32_t num_tasks);
+
+    /**
+    * The parallel for callback to run tasks on the caller-provided threading backend. The callback must execute
+    * task(task_context, i, num_tasks) exactly once for every i from 0 to num_tasks - 1 and return when all tasks are completed.
+    * The tasks never wait for each other, so they can be executed in any order, concurrently or sequentially.
+    * @param context The context passed to esa_matchfinder_create_parallel.
+    * @param num_tasks The number of tasks to run.
+    * @param task The task to run.
+    * @param task_context The opaque task context.
+    */
+    typedef void (* esa_matchfinder_parallel_for)(void * context, int32_t num_tasks, esa_matchfinder_task task, void * task_context);
+
     /**
     * Creates the enhanced suffix array (ESA) based match-finder for Lempel-Ziv factorization.
     * @param max_block_size The maximum block size to support (must be less or equal to ESA_MATCHFINDER_MAX_BLOCK_SIZE).
@@ -70,12 +98,109 @@ extern "C" {
     void * esa_matchfinder_create_omp(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads);
 #endif
 
+    /**
+    * Creates the enhanced suffix array (ESA) based match-finder for Lempel-Ziv factorization with multi-threaded optimization using
+    * caller-provided threading backend. Suffix array construction is not parallelized by the threading backend.
+    * @param max_block_size The maximum block size to support (must be less or equal to ESA_MATCHFINDER_MAX_BLOCK_SIZE).
+    * @param min_match_length The minimum match length to find (must be greater or equal to ESA_MATCHFINDER_MIN_MATCH_LENGTH).
+    * @param max_match_length The maximum match length to find (must be less or equal to ESA_MATCHFINDER_MAX_MATCH_LENGTH).
+    * @param num_threads The number of tasks to split parallel work into (can be 0 for default number of hardware threads).
+    * @param parallel_for The parallel for callback (can be NULL for default implementation based on a pool of native threads,
+    * which is created with the match-finder, reused for every parallel phase and joined when the match-finder is destroyed).
+    * @param context The context to pass to parallel for callback.
+    * @return The enhanced suffix array (ESA) based match-finder, NULL otherwise.
+    */
+    void * esa_matchfinder_create_parallel(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads, esa_matchfinder_parallel_for parallel_for, void * context);
+
+    /**
+    * Distributes the memory of the match-finder across NUMA nodes by first touching each thread's partition of the enhanced
+    * suffix array (ESA) from the thread that later processes the same partition during parsing. Must be called right after
+    * the match-finder is created (before the first parse), and is most effective with threads pinned to cores (e.g. OMP_PROC_BIND).
+    * The previously parsed block, if any, is discarded. Every block is then parsed in the layout of the maximum block size
+    * that was touched, instead of the smaller per-block layout, until esa_matchfinder_shrink or esa_matchfinder_release_memory
+    * discards the placement.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_numa_first_touch(void * mf);
+
+    /**
+    * Estimates the memory used by the match-finder created with the given parameters, including the suffix sorting
+    * context, the temporary suffix sorting context used by esa_matchfinder_parse_ex with fewer threads (OpenMP only)
+    * and the per-thread state used while parsing. The number of threads corresponds to esa_matchfinder_create_omp
+    * when compiled with OpenMP and to esa_matchfinder_create_parallel otherwise. Optional structures allocated on demand (query index, cursors,
+    * delta blocks, dictionaries and the bounded suffix sorting buckets) are not included.
+    * @param max_block_size The maximum block size to support (must be less or equal to ESA_MATCHFINDER_MAX_BLOCK_SIZE).
+    * @param min_match_length The minimum match length to find (must be greater or equal to ESA_MATCHFINDER_MIN_MATCH_LENGTH).
+    * @param max_match_length The maximum match length to find (must be less or equal to ESA_MATCHFINDER_MAX_MATCH_LENGTH).
+    * @param num_threads The number of threads to use (1 for single-threaded match-finder, can be 0 for default number of threads).
+    * @return The estimated memory in bytes, or -1 if the parameters are invalid.
+    */
+    int64_t esa_matchfinder_estimate_memory(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads);
+
+    /**
+    * Creates the match-finder with the largest maximum block size whose estimated memory usage fits into the budget.
+    * The selected block size can be queried with esa_matchfinder_get_max_block_size.
+    * @param memory_budget The memory budget in bytes.
+    * @param min_match_length The minimum match length to find (must be greater or equal to ESA_MATCHFINDER_MIN_MATCH_LENGTH).
+    * @param max_match_length The maximum match length to find (must be less or equal to ESA_MATCHFINDER_MAX_MATCH_LENGTH).
+    * @param num_threads The number of threads to use (1 for single-threaded match-finder, can be 0 for default number of threads).
+    * @return The enhanced suffix array (ESA) based match-finder, or NULL if the budget is too small or an error occurred.
+    */
+    void * esa_matchfinder_create_with_budget(int64_t memory_budget, int32_t min_match_length, int32_t max_match_length, int32_t num_threads);
+
+    /**
+    * Returns the maximum block size supported by the match-finder (rounded up to a multiple of 64).
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @return The maximum block size, or -1 if the match-finder is invalid.
+    */
+    int32_t esa_matchfinder_get_max_block_size(const void * mf);
+
+    /**
+    * Reduces the maximum block size of the match-finder and unmaps the tail of its storage in place, so that a long-running
+    * match-finder can give memory back after a large block without being recreated or allocating a new storage. The current
+    * block is discarded and existing cursors become invalid.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param max_block_size The new maximum block size (must be less or equal to the current maximum block size).
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_shrink(void * mf, int32_t max_block_size);
+
+    /**
+    * Returns the physical memory of the match-finder storage to the operating system while the match-finder is idle,
+    * keeping its address space reserved. The next parsed block only faults in the pages it touches. The current block
+    * is discarded and existing cursors become invalid.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_release_memory(void * mf);
+
     /**
     * Destroys the match-finder and frees previously allocated memory.
     * @param mf The enhanced suffix array (ESA) based match-finder.
     */
     void esa_matchfinder_destroy(void * mf);
 
+    /**
+    * Selects the suffix sorting algorithm used when parsing subsequent blocks. ESA_MATCHFINDER_SORT_FULL (the default) builds
+    * the full suffix array in linear time. ESA_MATCHFINDER_SORT_BOUNDED only orders suffixes by their first max_match_length
+    * bytes (ties are kept in position order), in O(n log n + n * max_match_length) expected time. It is faster on high-entropy input and,
+    * for maximum match lengths of up to 16, on periodic input, but slower on small-alphabet and natural language input.
+    * Both modes produce identical matches.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param sort_mode The suffix sorting algorithm (ESA_MATCHFINDER_SORT_FULL or ESA_MATCHFINDER_SORT_BOUNDED).
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_set_sort_mode(void * mf, int32_t sort_mode);
+
+    /**
+    * Returns the instruction set used by the vectorized kernels of the match-finder. The widest instruction set supported
+    * by both the build and the running processor is detected once when the match-finder is created.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @return One of ESA_MATCHFINDER_ISA_* constants, or -1 if the match-finder is invalid.
+    */
+    int32_t esa_matchfinder_get_isa(const void * mf);
+
     /**
     * Parses the input block by building enhanced suffix array (ESA) to speed up subsequent match-finding operations.
     * @param mf The enhanced suffix array (ESA) based match-finder.
@@ -85,6 +210,70 @@ extern "C" {
     */
     int32_t esa_matchfinder_parse(void * mf, const uint8_t * block, int32_t block_size);
 
+    /**
+    * Parses the input block by building enhanced suffix array (ESA) using the specified number of threads for this call only.
+    * The number of threads used by each phase is further reduced for smaller blocks, where thread startup outweighs the work.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param block The input block to parse.
+    * @param block_size The size of input block to parse.
+    * @param num_threads The number of threads to use (0 or values above the number of threads of the match-finder select the latter).
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_parse_ex(void * mf, const uint8_t * block, int32_t block_size, int32_t num_threads);
+
+    /**
+    * Parses the input block by building enhanced suffix array (ESA), and additionally retains the query index over suffix array
+    * to support stateless random-access match queries with esa_matchfinder_query. The query index is allocated on first use
+    * and kept until the match-finder is destroyed, shrunk or released. It takes about 14n bytes of additional memory for
+    * n = max_block_size (6n bytes for the wavelet matrix and 8n bytes for the interval bounds), and parsing temporarily
+    * needs another 8n bytes for a copy of the suffix array.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param block The input block to parse.
+    * @param block_size The size of input block to parse.
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_parse_with_query_index(void * mf, const uint8_t * block, int32_t block_size);
+
+    /**
+    * Parses multiple independent input blocks, each into its own match-finder. When the first match-finder was created with
+    * esa_matchfinder_create_parallel, the blocks are distributed as tasks over its threading backend (the native thread pool
+    * or the caller-provided parallel for callback), and each block is parsed by a single thread; otherwise the blocks are parsed in turn.
+    * @param mfs The array of enhanced suffix array (ESA) based match-finders (one per block, all distinct).
+    * @param blocks The array of input blocks to parse.
+    * @param block_sizes The array of sizes of input blocks to parse.
+    * @param count The number of input blocks to parse.
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_parse_batch(void ** mfs, const uint8_t ** blocks, const int32_t * block_sizes, int32_t count);
+
+#if defined(_OPENMP)
+    /**
+    * Parses multiple independent input blocks, each into its own match-finder, with multi-threaded optimization using OpenMP.
+    * The blocks are distributed between threads within single parallel region, so batches of small blocks are parsed in parallel.
+    * @param mfs The array of enhanced suffix array (ESA) based match-finders (one per block, all distinct).
+    * @param blocks The array of input blocks to parse.
+    * @param block_sizes The array of sizes of input blocks to parse.
+    * @param count The number of input blocks to parse.
+    * @param num_threads The number of OpenMP threads to use (can be 0 for default number of OpenMP threads).
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_parse_batch_omp(void ** mfs, const uint8_t ** blocks, const int32_t * block_sizes, int32_t count, int32_t num_threads);
+#endif
+
+    /**
+    * Parses the source and target blocks for delta compression, and positions the match-finder at the beginning of the target block.
+    * Both blocks are parsed as one concatenated block (source followed by target), so match positions and offsets are expressed in
+    * this concatenated address space, and offsets less than source_size refer to the source block. Source positions are inserted
+    * into the match-finder in bulk, so only target positions have to be queried.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param source The source block (old version) to find matches in.
+    * @param source_size The size of source block.
+    * @param target The target block (new version) to find matches for.
+    * @param target_size The size of target block (combined size of source and target must not exceed max_block_size).
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_parse_delta(void * mf, const uint8_t * source, int32_t source_size, const uint8_t * target, int32_t target_size);
+
     /**
     * Gets the current match-finder position.
     * @param mf The enhanced suffix array (ESA) based match-finder.
@@ -134,6 +323,16 @@ extern "C" {
     */
     ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match_in_window(void * mf, uint64_t window_size);
 
+    /**
+    * Finds the best match at the current position of the match-finder, and then advances the position by one byte.
+    * Unlike esa_matchfinder_find_best_match, the traversal stops as soon as a match of at least nice_match_length is found,
+    * and updates of shorter intervals are deferred until they are needed. The result is identical to esa_matchfinder_find_best_match.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param nice_match_length The match length that is considered good enough to stop the traversal.
+    * @return The best match found (match of zero length and zero offset is returned if no matches were found).
+    */
+    ESA_MATCHFINDER_MATCH esa_matchfinder_find_nice_match(void * mf, int32_t nice_match_length);
+
     /**
     * Advances the match-finder position forward by the specified number of bytes without recording matches.
     * @param mf The enhanced suffix array (ESA) based match-finder.
@@ -141,6 +340,183 @@ extern "C" {
     */
     void esa_matchfinder_advance(void * mf, int32_t count);
 
+    /**
+    * Computes the longest previous factor (LPF) and its nearest source for every position of the parsed input block.
+    * For each position the result is identical to esa_matchfinder_find_best_match, but positions are processed in parallel
+    * by independent subtrees of the interval tree. The match-finder is rewound to the beginning of the block afterwards.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param lengths The output array of block_size elements to record the lengths of longest previous factors (or zero).
+    * @param sources The output array of block_size elements to record the offsets of nearest sources (or zero).
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_compute_lpf(void * mf, int32_t * lengths, int32_t * sources);
+
+    /**
+    * Finds all distance-optimal matches at the specified position without changing the state of the match-finder.
+    * The recorded matches are identical to esa_matchfinder_find_all_matches at that position, but do not depend on the current position.
+    * The input block must be parsed with esa_matchfinder_parse_with_query_index. The function is safe to call concurrently from multiple
+    * threads, provided that no other match-finder functions are called on the same match-finder at the same time.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param position The position in the input block to find matches at.
+    * @param matches The output array to record the matches (array must be of ESA_MATCHFINDER_MAX_MATCH_LENGTH size).
+    * @return The pointer to the end of recorded matches array (if no matches were found, this will be the same as matches), NULL on error.
+    */
+    ESA_MATCHFINDER_MATCH * esa_matchfinder_query(const void * mf, int32_t position, ESA_MATCHFINDER_MATCH * matches);
+
+    /**
+    * Creates the lightweight cursor over the parsed match-finder. The cursor keeps its own position and match offsets, and only reads
+    * a read-only copy of the interval tree without match offsets, which the match-finder allocates when the first cursor is created
+    * (8n bytes of additional memory) and refreshes on every parse. Multiple cursors and the match-finder itself can therefore find
+    * matches concurrently from different threads. The cursor is positioned at the beginning of the block, and must be rewound after
+    * the match-finder parses another block (which must not run concurrently with cursors).
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @return The match-finder cursor, NULL otherwise.
+    */
+    void * esa_matchfinder_cursor_create(void * mf);
+
+    /**
+    * Destroys the match-finder cursor and frees previously allocated memory.
+    * @param mf_cursor The match-finder cursor.
+    */
+    void esa_matchfinder_cursor_destroy(void * mf_cursor);
+
+    /**
+    * Gets the current match-finder cursor position.
+    * @param mf_cursor The match-finder cursor.
+    * @return The current match-finder cursor position.
+    */
+    int32_t esa_matchfinder_cursor_get_position(void * mf_cursor);
+
+    /**
+    * Rewinds the match-finder cursor forward or backward to the specified position.
+    * @param mf_cursor The match-finder cursor.
+    * @param position The match-finder cursor position to rewind to.
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_cursor_rewind(void * mf_cursor, int32_t position);
+
+    /**
+    * Finds all distance-optimal matches at the current position of the match-finder cursor, and then advances the position by one byte.
+    * The recorded matches will be sorted by strictly decreasing length and strictly increasing offset from the beginning of the block.
+    * @param mf_cursor The match-finder cursor.
+    * @param matches The output array to record the matches (array must be of ESA_MATCHFINDER_MAX_MATCH_LENGTH size).
+    * @return The pointer to the end of recorded matches array (if no matches were found, this will be the same as matches).
+    */
+    ESA_MATCHFINDER_MATCH * esa_matchfinder_cursor_find_all_matches(void * mf_cursor, ESA_MATCHFINDER_MATCH * matches);
+
+    /**
+    * Finds all distance-optimal matches within a specified sliding window at the current position of the match-finder cursor, and then advances the position by one byte.
+    * The recorded matches will be sorted by strictly decreasing length and strictly increasing offset from the beginning of the block.
+    * @param mf_cursor The match-finder cursor.
+    * @param matches The output array to record the matches (array must be of ESA_MATCHFINDER_MAX_MATCH_LENGTH size).
+    * @param window_size The maximum allowed distance between the current position and found matches.
+    * @return The pointer to the end of recorded matches array (if no matches were found, this will be the same as matches).
+    */
+    ESA_MATCHFINDER_MATCH * esa_matchfinder_cursor_find_all_matches_in_window(void * mf_cursor, ESA_MATCHFINDER_MATCH * matches, uint64_t window_size);
+
+    /**
+    * Finds the best match at the current position of the match-finder cursor, and then advances the position by one byte.
+    * @param mf_cursor The match-finder cursor.
+    * @return The best match found (match of zero length and zero offset is returned if no matches were found).
+    */
+    ESA_MATCHFINDER_MATCH esa_matchfinder_cursor_find_best_match(void * mf_cursor);
+
+    /**
+    * Finds the best match within a specified sliding window at the current position of the match-finder cursor, and then advances the position by one byte.
+    * @param mf_cursor The match-finder cursor.
+    * @param window_size The maximum allowed distance between the current position and found match.
+    * @return The best match found (match of zero length and zero offset is returned if no matches were found).
+    */
+    ESA_MATCHFINDER_MATCH esa_matchfinder_cursor_find_best_match_in_window(void * mf_cursor, uint64_t window_size);
+
+    /**
+    * Advances the match-finder cursor position forward by the specified number of bytes without recording matches.
+    * @param mf_cursor The match-finder cursor.
+    * @param count The number of bytes to advance.
+    */
+    void esa_matchfinder_cursor_advance(void * mf_cursor, int32_t count);
+
+    /**
+    * Creates the pre-parsed dictionary, which can be attached to multiple match-finders to find matches into the dictionary
+    * in addition to matches within the input block. The dictionary is read-only after creation and can be shared between threads.
+    * @param dictionary The dictionary content (copied by the function).
+    * @param dictionary_size The size of dictionary (must be less or equal to ESA_MATCHFINDER_MAX_BLOCK_SIZE).
+    * @param min_match_length The minimum match length to find (must match the match-finder the dictionary is attached to).
+    * @param max_match_length The maximum match length to find (must match the match-finder the dictionary is attached to).
+    * @return The pre-parsed dictionary, NULL otherwise.
+    */
+    void * esa_matchfinder_create_dictionary(const uint8_t * dictionary, int32_t dictionary_size, int32_t min_match_length, int32_t max_match_length);
+
+    /**
+    * Destroys the pre-parsed dictionary and frees previously allocated memory.
+    * @param dictionary The pre-parsed dictionary.
+    */
+    void esa_matchfinder_destroy_dictionary(void * dictionary);
+
+    /**
+    * Attaches the pre-parsed dictionary to the match-finder (or detaches it, if dictionary is NULL).
+    * The input block passed to esa_matchfinder_parse must remain valid while matches with dictionary are searched.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param dictionary The pre-parsed dictionary.
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_set_dictionary(void * mf, const void * dictionary);
+
+    /**
+    * Finds all distance-optimal matches into the attached dictionary and the input block at the current position of the match-finder,
+    * and then advances the position by one byte. Matches into the dictionary have negative offsets (offset + dictionary_size is the
+    * position in the dictionary) and never extend past the end of the dictionary. The recorded matches will be sorted by strictly
+    * decreasing length and strictly increasing offset.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @param matches The output array to record the matches (array must be of ESA_MATCHFINDER_MAX_MATCH_LENGTH size).
+    * @return The pointer to the end of recorded matches array (if no matches were found, this will be the same as matches).
+    */
+    ESA_MATCHFINDER_MATCH * esa_matchfinder_find_all_matches_with_dictionary(void * mf, ESA_MATCHFINDER_MATCH * matches);
+
+    /**
+    * Finds the best match into the attached dictionary and the input block at the current position of the match-finder,
+    * and then advances the position by one byte. Matches into the dictionary have negative offsets.
+    * @param mf The enhanced suffix array (ESA) based match-finder.
+    * @return The best match found (match of zero length and zero offset is returned if no matches were found).
+    */
+    ESA_MATCHFINDER_MATCH esa_matchfinder_find_best_match_with_dictionary(void * mf);
+
+    /**
+    * Creates the double-buffered pipeline of two match-finders for multi-block streams. The next block is parsed on
+    * the background thread while the caller finds matches in the current block, so parsing overlaps with factorization.
+    * @param max_block_size The maximum block size to support (must be less or equal to ESA_MATCHFINDER_MAX_BLOCK_SIZE).
+    * @param min_match_length The minimum match length to find (must be greater or equal to ESA_MATCHFINDER_MIN_MATCH_LENGTH).
+    * @param max_match_length The maximum match length to find (must be less or equal to ESA_MATCHFINDER_MAX_MATCH_LENGTH).
+    * @param num_threads The number of threads to use for parsing (can be 0 for default number of threads; without OpenMP
+    * the match-finders use the native thread pool of esa_matchfinder_create_parallel when num_threads is not 1).
+    * @return The match-finder pipeline, NULL otherwise.
+    */
+    void * esa_matchfinder_create_pipeline(int32_t max_block_size, int32_t min_match_length, int32_t max_match_length, int32_t num_threads);
+
+    /**
+    * Destroys the match-finder pipeline, waits for the background thread to finish and frees previously allocated memory.
+    * @param mf_pipeline The match-finder pipeline.
+    */
+    void esa_matchfinder_destroy_pipeline(void * mf_pipeline);
+
+    /**
+    * Submits the next input block to be parsed on the background thread. Only one block can be submitted ahead, so the
+    * previously submitted block must be taken with esa_matchfinder_pipeline_next_block before the next one is submitted.
+    * @param mf_pipeline The match-finder pipeline.
+    * @param block The input block to parse (must remain valid until the block is no longer used for match-finding).
+    * @param block_size The size of input block to parse.
+    * @return 0 if no error occurred, -1 otherwise.
+    */
+    int32_t esa_matchfinder_pipeline_submit(void * mf_pipeline, const uint8_t * block, int32_t block_size);
+
+    /**
+    * Waits for the submitted block to be parsed and hands off the match-finder for it. The returned match-finder remains
+    * valid until the next call to this function, and the match-finder returned by the previous call must no longer be used.
+    * @param mf_pipeline The match-finder pipeline.
+    * @return The match-finder positioned at the beginning of the submitted block, NULL if no block was submitted or parsing failed.
+    */
+    void * esa_matchfinder_pipeline_next_block(void * mf_pipeline);
+
 #ifdef __cplusplus
 }
 #endif